@@ -0,0 +1,43 @@
+// Copyright 2024 Daniel Beale CC BY-NC-SA 4.0
+#ifndef BENCHMARKS_BENCHMARK_HPP_
+#define BENCHMARKS_BENCHMARK_HPP_
+
+#include <algorithm>
+#include <chrono>  // NOLINT(build/c++11)
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+template<class F>
+/**
+ * \brief The shortest time of several runs of a function, in seconds.
+ */
+double time_best(const F& func, const size_t nRuns = 5) {
+    double best = 0;
+    for ( size_t r = 0; r < nRuns; ++r ) {
+        const auto start = std::chrono::steady_clock::now();
+        func();
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        best = (r == 0) ? elapsed.count() : std::min(best, elapsed.count());
+    }
+    return best;
+}
+
+/**
+ * \brief Print the time of a case and its ratio to a baseline.
+ */
+void report(const std::string& name, const double seconds, const double baseline) {
+    std::cout << "    " << std::left << std::setw(40) << name;
+    std::cout << std::right << std::setw(12) << std::fixed << std::setprecision(6) << seconds << " s";
+    std::cout << std::setw(10) << std::setprecision(3) << seconds / baseline << "x" << std::endl;
+}
+
+/**
+ * \brief Prevent the compiler from removing a computed value.
+ */
+template<typename T>
+void keep(const T& value) {
+    asm volatile("" : : "g"(&value) : "memory");
+}
+
+#endif  // BENCHMARKS_BENCHMARK_HPP_
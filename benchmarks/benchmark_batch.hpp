@@ -0,0 +1,63 @@
+// Copyright 2024 Daniel Beale CC BY-NC-SA 4.0
+#ifndef BENCHMARKS_BENCHMARK_BATCH_HPP_
+#define BENCHMARKS_BENCHMARK_BATCH_HPP_
+
+#include <array>
+#include <string>
+#include <vector>
+
+#include "./benchmark.hpp"
+#include "base/dimensions.hpp"
+
+/**
+ * \brief Compare the scalar and batched index conversions of every point
+ * at a level, in both directions.
+ */
+void benchmark_batch_case(const std::string& name, const gs::dimensions<3>& dims, const uint32_t level) {
+    const auto subDiv = gs::dimensions<3>::BOXES_SUBDIVISION;
+    const auto mode = gs::dimensions<3>::POINTS_MODE;
+    const uint32_t size = dims.max_ind(level, subDiv, mode);
+    std::vector<uint32_t> inds(size);
+    for ( uint32_t i = 0; i < size; ++i ) inds[i] = i;
+    std::array<std::vector<uint32_t>, 3> subs;
+    for ( auto& sub : subs ) sub.resize(size);
+    std::vector<uint32_t> out(size);
+
+    const double scalarInd2sub = time_best([&]() {
+        for ( uint32_t i = 0; i < size; ++i ) {
+            const auto sub = dims.ind2sub(inds[i], level, subDiv, mode);
+            for ( size_t d = 0; d < 3; ++d ) subs[d][i] = sub[d];
+        }
+        keep(subs);
+    });
+    const double batchedInd2sub = time_best([&]() {
+        dims.ind2sub(inds, {subs[0], subs[1], subs[2]}, level, subDiv, mode);
+        keep(subs);
+    });
+    const double scalarSub2ind = time_best([&]() {
+        for ( uint32_t i = 0; i < size; ++i ) {
+            out[i] = dims.sub2ind({subs[0][i], subs[1][i], subs[2][i]}, level, subDiv, mode);
+        }
+        keep(out);
+    });
+    const double batchedSub2ind = time_best([&]() {
+        dims.sub2ind({subs[0], subs[1], subs[2]}, out, level, subDiv, mode);
+        keep(out);
+    });
+    report("ind2sub " + name + ", scalar", scalarInd2sub, scalarInd2sub);
+    report("ind2sub " + name + ", batched", batchedInd2sub, scalarInd2sub);
+    report("sub2ind " + name + ", scalar", scalarSub2ind, scalarSub2ind);
+    report("sub2ind " + name + ", batched", batchedSub2ind, scalarSub2ind);
+}
+
+/**
+ * \brief Compare the scalar and batched index conversions, with and
+ * without the power of two conversions.
+ */
+void benchmark_batch() {
+    std::cout << "Benchmark batched conversions" << std::endl;
+    benchmark_batch_case("3D level 7", gs::dimensions<3>(2, 8), 7);
+    benchmark_batch_case("3D level 5, odd", gs::dimensions<3>({2, 6, 10}, 8), 5);
+}
+
+#endif  // BENCHMARKS_BENCHMARK_BATCH_HPP_
@@ -0,0 +1,109 @@
+// Copyright 2024 Daniel Beale CC BY-NC-SA 4.0
+#ifndef BENCHMARKS_BENCHMARK_INDEX_HPP_
+#define BENCHMARKS_BENCHMARK_INDEX_HPP_
+
+#include <array>
+#include <vector>
+
+#include "./benchmark.hpp"
+#include "base/dimensions.hpp"
+#include "base/box.hpp"
+#include "base/box_handle.hpp"
+#include "estimators/exp_squared_est.hpp"
+#include "implementation/analytic_multiply.hpp"
+
+template<int N, typename S>
+/**
+ * \brief Convert every point of a grid to its subscript and back.
+ */
+S index_round_trip(const gs::dimensions<N, S>& dims, const S level) {
+    const auto subDiv = gs::dimensions<N, S>::BOXES_SUBDIVISION;
+    const S size = dims.max_ind(level, subDiv, gs::dimensions<N, S>::POINTS_MODE);
+    S total = 0;
+    for ( S i = 0; i < size; ++i ) {
+        total += dims.sub2ind(dims.ind2sub(i, level, subDiv), level, subDiv);
+    }
+    return total;
+}
+
+template<int N, typename S>
+/**
+ * \brief Construct every box at a level and walk up to the root.
+ */
+S box_navigation(const gs::dimensions<N, S>& dims, const S level) {
+    const auto subDiv = gs::dimensions<N, S>::BOXES_SUBDIVISION;
+    const S size = dims.max_ind(level, subDiv, gs::dimensions<N, S>::BOXES_MODE);
+    S total = 0;
+    for ( S i = 0; i < size; ++i ) {
+        gs::box<N, S> boxVal(dims, level, subDiv, i);
+        while ( boxVal.get_level() > 0 ) {
+            total += boxVal.index_in_parent();
+            boxVal = boxVal.parent();
+        }
+    }
+    return total;
+}
+
+template<int N, typename S>
+/**
+ * \brief Walk every box handle at a level up to the root.
+ */
+S handle_navigation(const gs::dimensions<N, S>& dims, const S level) {
+    const auto subDiv = gs::dimensions<N, S>::BOXES_SUBDIVISION;
+    const S size = dims.max_ind(level, subDiv, gs::dimensions<N, S>::BOXES_MODE);
+    S total = 0;
+    for ( S i = 0; i < size; ++i ) {
+        gs::box_handle<N, S> handle(level, i);
+        while ( handle.get_level() > 0 ) {
+            total += handle.index_in_parent(dims, subDiv);
+            handle = handle.parent(dims, subDiv);
+        }
+    }
+    return total;
+}
+
+template<typename S>
+/**
+ * \brief A multiplication on a 2D grid with the specified index type.
+ */
+double time_multiply(const uint32_t maxLevel) {
+    const size_t nDims = 2;
+    const size_t nDegree = 6;
+    using multiply = gs::analytic_multiply<double, nDims, nDegree, gs::exp_squared_est, 1, double, S>;
+    const gs::dimensions<nDims, S> dims(2, maxLevel);
+    multiply mult(dims, gs::exp_squared_est<double, nDims, nDegree>(2.5));
+    std::vector<double> input(mult.get_plan()->size());
+    for ( size_t i = 0; i < input.size(); ++i ) {
+        input[i] = static_cast<double>((i*7) % 13) - 6.0;
+    }
+    mult.initialise(input);
+    return time_best([&]() {mult.compute();}, 3);
+}
+
+/**
+ * \brief Compare 32 and 64 bit index types on the index conversions and
+ * on a whole multiplication.
+ */
+void benchmark_index_type() {
+    std::cout << "Benchmark index type" << std::endl;
+    const gs::dimensions<3, uint32_t> narrow(2, 8);
+    const gs::dimensions<3, uint64_t> wide(2, 8);
+    const double narrowRoundTrip = time_best([&]() {keep(index_round_trip(narrow, uint32_t(7)));});
+    const double wideRoundTrip = time_best([&]() {keep(index_round_trip(wide, uint64_t(7)));});
+    report("sub2ind(ind2sub) 3D level 7, uint32_t", narrowRoundTrip, narrowRoundTrip);
+    report("sub2ind(ind2sub) 3D level 7, uint64_t", wideRoundTrip, narrowRoundTrip);
+
+    const double narrowNavigation = time_best([&]() {keep(box_navigation(narrow, uint32_t(6)));});
+    const double wideNavigation = time_best([&]() {keep(box_navigation(wide, uint64_t(6)));});
+    report("box parents 3D level 6, uint32_t", narrowNavigation, narrowNavigation);
+    report("box parents 3D level 6, uint64_t", wideNavigation, narrowNavigation);
+    const double handleNavigation = time_best([&]() {keep(handle_navigation(narrow, uint32_t(6)));});
+    report("box handle parents 3D level 6, uint32_t", handleNavigation, narrowNavigation);
+
+    const double narrowMultiply = time_multiply<uint32_t>(7);
+    const double wideMultiply = time_multiply<uint64_t>(7);
+    report("multiply 2D 128x128, uint32_t", narrowMultiply, narrowMultiply);
+    report("multiply 2D 128x128, uint64_t", wideMultiply, narrowMultiply);
+}
+
+#endif  // BENCHMARKS_BENCHMARK_INDEX_HPP_
@@ -0,0 +1,10 @@
+// Copyright 2024 Daniel Beale CC BY-NC-SA 4.0
+
+#include "./benchmark_index.hpp"
+#include "./benchmark_batch.hpp"
+
+int main(int, char* argv[]) {
+    std::cout << argv[0] << " benchmarks" << std::endl;
+    benchmark_index_type();
+    benchmark_batch();
+}
@@ -0,0 +1,316 @@
+// Copyright 2024 Daniel Beale CC BY-NC-SA 4.0
+#ifndef LIB_ALGORITHM_ADAPTIVE_TREE_HPP_
+#define LIB_ALGORITHM_ADAPTIVE_TREE_HPP_
+
+#include <inttypes.h>
+#include <span>
+
+#include <algorithm>
+#include <array>
+#include <utility>
+#include <vector>
+
+#include "base/tools.hpp"
+#include "base/dimensions.hpp"
+#include "math/vector.hpp"
+
+namespace gs {
+template<int N, typename T, typename S = uint32_t>
+requires std::is_floating_point<T>::value && std::is_integral<S>::value && std::is_unsigned<S>::value && (N > 0)
+/**
+ * \brief An adaptive 2^N tree over a collection of scattered points.
+ *
+ * The points are enclosed in a cube, which is the single box at level 0.
+ * The boxes at each level are those of a grid with box subdivision, and so
+ * each box is split into 2^N children of half the width. A box is only split
+ * if it contains more than the leaf size of points, and only the children
+ * which contain points are kept, so the size of the tree scales with the
+ * number of points rather than with the volume that they cover.
+ *
+ * The points are reordered so that the points of every box are contiguous,
+ * and the boxes are stored in breadth first order, so that the children of
+ * a box are contiguous and follow their parent.
+ *
+ * The interaction lists are found with a dual traversal of the tree. Each
+ * pair of boxes is either separated, in which case the source box is in the
+ * far list of the target box, or split until both are leaves, in which case
+ * the source is in the near list of the target. The pairs cover every pair
+ * of points exactly once. Two boxes are separated when the gap between them
+ * is at least the width of the larger, which for boxes at the same level is
+ * the same rule as the interaction_list of the grid.
+ *
+ * The template parameters,
+ *      N - The number of dimensions of the points.
+ *      T - The floating point type of the points.
+ *      S - The integral type.
+ */
+class adaptive_tree {
+ public:
+    static constexpr S m_nChildren = pow<2, N>();  ///< The maximum number of children of each box.
+
+    /**
+     * \brief A box in the tree.
+     */
+    struct node {
+        S m_level;  ///< The level of the box.
+        std::array<S, N> m_index;  ///< The index of the box at its level.
+        S m_parent;  ///< The parent box, the root is its own parent.
+        S m_firstPoint;  ///< The first point in the box.
+        S m_lastPoint;  ///< One past the last point in the box.
+        S m_firstChild;  ///< The first child of the box.
+        S m_lastChild;  ///< One past the last child of the box.
+
+        bool is_leaf() const {return m_firstChild == m_lastChild;}  ///< True if the box has no children.
+        S size() const {return m_lastPoint - m_firstPoint;}  ///< The number of points in the box.
+    };
+
+ private:
+    dimensions<N, S> m_dimensions;  ///< The boxes at each level.
+    gs::vector<T, N> m_origin;  ///< The first corner of the root box.
+    T m_width;  ///< The width of the root box.
+    std::vector<gs::vector<T, N>> m_points;  ///< The points, in tree order.
+    std::vector<S> m_order;  ///< The original index of each point, in tree order.
+    std::vector<node> m_nodes;  ///< The boxes, in breadth first order.
+    std::vector<gs::vector<T, N>> m_centers;  ///< The center of each box.
+    std::vector<S> m_farStart;  ///< The start of each box in the far lists.
+    std::vector<S> m_far;  ///< The boxes which are separated from each box.
+    std::vector<S> m_nearStart;  ///< The start of each box in the near lists.
+    std::vector<S> m_near;  ///< The leaves which are adjacent to each leaf.
+
+    /**
+     * \brief The width of a box at the specified level.
+     */
+    T width(const S level) const {
+        const auto levelDims = m_dimensions.level_dims(
+            level,
+            dimensions<N, S>::BOXES_SUBDIVISION,
+            dimensions<N, S>::BOXES_MODE
+        );
+        return m_width / static_cast<T>(levelDims[0]);
+    }
+
+    /**
+     * \brief The center of a box.
+     */
+    gs::vector<T, N> box_center(const node& box) const {
+        const T boxWidth = width(box.m_level);
+        gs::vector<T, N> center = m_origin;
+        for ( S d = 0; d < N; ++d ) {
+            center(d) += (static_cast<T>(box.m_index[d]) + 0.5)*boxWidth;
+        }
+        return center;
+    }
+
+    /**
+     * \brief True if the gap between two boxes is at least the width of
+     * the larger box.
+     *
+     * The boxes are compared on the integer lattice of the finest level,
+     * and so the test is exact.
+     */
+    bool separated(const node& a, const node& b) const {
+        const S finest = m_dimensions.max_level()-1;
+        const int64_t sizeA = int64_t(1) << (finest - a.m_level);
+        const int64_t sizeB = int64_t(1) << (finest - b.m_level);
+        for ( S d = 0; d < N; ++d ) {
+            const int64_t lowA = a.m_index[d]*sizeA;
+            const int64_t lowB = b.m_index[d]*sizeB;
+            const int64_t gap = std::max(lowB - (lowA + sizeA), lowA - (lowB + sizeB));
+            if ( gap >= std::max(sizeA, sizeB) ) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * \brief The child of a box which contains a point.
+     */
+    static S child_of(const gs::vector<T, N>& point, const gs::vector<T, N>& center) {
+        S child = 0;
+        for ( S d = 0; d < N; ++d ) {
+            child |= static_cast<S>(point(d) >= center(d)) << d;
+        }
+        return child;
+    }
+
+    /**
+     * \brief Split a box into its children, if it has too many points.
+     */
+    void subdivide(const S i, const S leafSize, std::vector<gs::vector<T, N>>& points, std::vector<S>& order) {
+        const node parent = m_nodes[i];
+        m_nodes[i].m_firstChild = m_nodes.size();
+        m_nodes[i].m_lastChild = m_nodes.size();
+        if ( parent.size() <= leafSize || parent.m_level + 1 >= m_dimensions.max_level() ) {
+            return;
+        }
+
+        // Sort the points into their children by counting
+        const auto& center = m_centers[i];
+        std::array<S, m_nChildren+1> starts;
+        starts.fill(0);
+        for ( S p = parent.m_firstPoint; p < parent.m_lastPoint; ++p ) {
+            ++starts[child_of(m_points[p], center)+1];
+        }
+        for ( S c = 0; c < m_nChildren; ++c ) {
+            starts[c+1] += starts[c];
+        }
+        auto next = starts;
+        for ( S p = parent.m_firstPoint; p < parent.m_lastPoint; ++p ) {
+            const S q = parent.m_firstPoint + next[child_of(m_points[p], center)]++;
+            points[q] = m_points[p];
+            order[q] = m_order[p];
+        }
+        std::copy(points.begin() + parent.m_firstPoint, points.begin() + parent.m_lastPoint, m_points.begin() + parent.m_firstPoint);
+        std::copy(order.begin() + parent.m_firstPoint, order.begin() + parent.m_lastPoint, m_order.begin() + parent.m_firstPoint);
+
+        // Only the children which contain points are kept
+        for ( S c = 0; c < m_nChildren; ++c ) {
+            if ( starts[c] == starts[c+1] ) continue;
+            node child;
+            child.m_level = parent.m_level + 1;
+            for ( S d = 0; d < N; ++d ) {
+                child.m_index[d] = 2*parent.m_index[d] + ((c >> d) & 1);
+            }
+            child.m_parent = i;
+            child.m_firstPoint = parent.m_firstPoint + starts[c];
+            child.m_lastPoint = parent.m_firstPoint + starts[c+1];
+            m_nodes.push_back(child);
+            m_centers.push_back(box_center(child));
+        }
+        m_nodes[i].m_lastChild = m_nodes.size();
+    }
+
+    /**
+     * \brief Find the near and far lists with a dual traversal of the tree.
+     *
+     * The pairs of boxes are kept on the heap rather than the stack. When a
+     * pair is neither separated nor a pair of leaves, the larger box is split.
+     */
+    void add_interactions() {
+        std::vector<std::vector<S>> farLists(m_nodes.size());
+        std::vector<std::vector<S>> nearLists(m_nodes.size());
+        std::vector<std::pair<S, S>> pairs{{0, 0}};
+        while ( !pairs.empty() ) {
+            const auto [target, source] = pairs.back();
+            pairs.pop_back();
+            const node& targetBox = m_nodes[target];
+            const node& sourceBox = m_nodes[source];
+            if ( target != source && separated(targetBox, sourceBox) ) {
+                farLists[target].push_back(source);
+            } else if ( targetBox.is_leaf() && sourceBox.is_leaf() ) {
+                nearLists[target].push_back(source);
+            } else if ( sourceBox.is_leaf() || (!targetBox.is_leaf() && targetBox.m_level <= sourceBox.m_level) ) {
+                for ( S c = targetBox.m_firstChild; c < targetBox.m_lastChild; ++c ) {
+                    pairs.push_back({c, source});
+                }
+            } else {
+                for ( S c = sourceBox.m_firstChild; c < sourceBox.m_lastChild; ++c ) {
+                    pairs.push_back({target, c});
+                }
+            }
+        }
+        for ( S i = 0; i < m_nodes.size(); ++i ) {
+            m_farStart.push_back(m_far.size());
+            m_far.insert(m_far.end(), farLists[i].begin(), farLists[i].end());
+            m_nearStart.push_back(m_near.size());
+            m_near.insert(m_near.end(), nearLists[i].begin(), nearLists[i].end());
+        }
+        m_farStart.push_back(m_far.size());
+        m_nearStart.push_back(m_near.size());
+    }
+
+ public:
+    /**
+     * \brief Build the tree over a collection of points.
+     *
+     * A box with more than leafSize points is split, unless it is at
+     * the maximum level.
+     */
+    adaptive_tree(const std::vector<gs::vector<T, N>>& points, const S leafSize = 16, const S maxLevel = 16):
+        m_dimensions(2, maxLevel),
+        m_width(0),
+        m_points(points),
+        m_order(points.size()) {
+        if ( points.empty() ) {
+            throw std::range_error("No points");
+        }
+        if ( maxLevel == 0 || maxLevel > 8*sizeof(S) - 1 ) {
+            throw std::range_error("Incorrect maximum level");
+        }
+        for ( S i = 0; i < m_order.size(); ++i ) {
+            m_order[i] = i;
+        }
+
+        // The root box is the smallest cube containing every point
+        m_origin = points[0];
+        gs::vector<T, N> upper = points[0];
+        for ( const auto& point : points ) {
+            for ( S d = 0; d < N; ++d ) {
+                m_origin(d) = std::min(m_origin(d), point(d));
+                upper(d) = std::max(upper(d), point(d));
+            }
+        }
+        for ( S d = 0; d < N; ++d ) {
+            m_width = std::max(m_width, upper(d) - m_origin(d));
+        }
+        if ( m_width == 0 ) m_width = 1;
+
+        node root;
+        root.m_level = 0;
+        root.m_index.fill(0);
+        root.m_parent = 0;
+        root.m_firstPoint = 0;
+        root.m_lastPoint = points.size();
+        m_nodes.push_back(root);
+        m_centers.push_back(box_center(root));
+
+        // Each box is split in breadth first order
+        std::vector<gs::vector<T, N>> pointBuffer(points.size());
+        std::vector<S> orderBuffer(points.size());
+        for ( S i = 0; i < m_nodes.size(); ++i ) {
+            subdivide(i, leafSize, pointBuffer, orderBuffer);
+        }
+        add_interactions();
+    }
+
+    /**
+     * \brief Get the dimensions of the boxes at each level.
+     */
+    const dimensions<N, S>& get_dimensions() const {return m_dimensions;}
+
+    size_t size() const {return m_points.size();}  ///< The number of points.
+    size_t n_nodes() const {return m_nodes.size();}  ///< The number of boxes.
+    const node& operator[](const S i) const {return m_nodes[i];}  ///< Access the ith box.
+    const gs::vector<T, N>& point(const S p) const {return m_points[p];}  ///< The pth point in tree order.
+    S order(const S p) const {return m_order[p];}  ///< The original index of the pth point in tree order.
+    const gs::vector<T, N>& center(const S i) const {return m_centers[i];}  ///< The center of the ith box.
+
+    /**
+     * \brief The points of the ith box, in tree order.
+     */
+    std::span<const gs::vector<T, N>> points(const S i) const {
+        return std::span<const gs::vector<T, N>>(m_points).subspan(
+            m_nodes[i].m_firstPoint,
+            m_nodes[i].m_lastPoint - m_nodes[i].m_firstPoint
+        );
+    }
+
+    /**
+     * \brief The boxes in the far field of the ith box.
+     */
+    std::span<const S> far(const S i) const {
+        return std::span<const S>(m_far.data() + m_farStart[i], m_farStart[i+1] - m_farStart[i]);
+    }
+
+    /**
+     * \brief The leaves which are not separated from the ith box, which
+     * is empty unless the box is a leaf.
+     */
+    std::span<const S> near(const S i) const {
+        return std::span<const S>(m_near.data() + m_nearStart[i], m_nearStart[i+1] - m_nearStart[i]);
+    }
+};
+}  // namespace gs
+
+#endif  // LIB_ALGORITHM_ADAPTIVE_TREE_HPP_
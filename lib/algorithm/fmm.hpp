@@ -2,7 +2,11 @@
 #ifndef LIB_ALGORITHM_FMM_HPP_
 #define LIB_ALGORITHM_FMM_HPP_
 
-#include "base/pattern.hpp"
+#include <memory_resource>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "base/concepts.hpp"
 #include "base/grid.hpp"
 #include "base/box_duel_iterator.hpp"
 #include "math/polynomial.hpp"
@@ -13,6 +17,8 @@ template<
     typename T,
     class FTraversal,
     class FBoxWeight,
+    class FBoxAggregate,
+    class FBoxLocal,
     class GridElement,
     class BoxElement
 >
@@ -28,6 +34,16 @@ requires(
         const box_stack<N, T>&,
         grid<N, GridElement, BoxElement, T>&
     > &&
+    std::invocable<
+        FBoxAggregate&,
+        const box_handle<N, T>&,
+        grid<N, GridElement, BoxElement, T>&
+    > &&
+    std::invocable<
+        FBoxLocal&,
+        const box_handle<N, T>&,
+        grid<N, GridElement, BoxElement, T>&
+    > &&
     (N > 0)
 )
 /**
@@ -53,47 +69,345 @@ requires(
  *      N           - The number of dimensions of the underlying grid.
  *      T           - The base integral type.
  *      FTraversal  - The function used to traverse each of the finest grid boxes.
+ *                    It may only write to the corners of the box it is given.
  *      FBoxWeight  - A function which takes a list of points in a box and produces a
  *                    box value, to be used as a weight in the far field equation.
+ *                    It is called on the stacks of the leaves, and may only write
+ *                    to the leaf at the end of the stack.
+ *      FBoxAggregate - A function which produces the box value of a box from the
+ *                    values of its children, which have already been computed.
+ *                    The box is given as a handle, to be navigated with the
+ *                    grid.
+ *      FBoxLocal   - A function which produces the local expansion of a box from
+ *                    the local expansion of its parent, which has already been
+ *                    computed, and the box values of its interaction list. The
+ *                    box is given as a handle.
  *      GridElement - The element type to be stored at each point in the grid.
  *      BoxElement  - The element type to be stored at each box in the tree.
  */
 class fmm {
     using subdivision_type = typename dimensions<N, T>::subdivision_type;
+    using storage_layout = typename grid<N, GridElement, BoxElement, T>::storage_layout;
 
     grid<N, GridElement, BoxElement, T> m_grid;  ///< The underlying grid.
     FTraversal m_fineTraversalFunc;  ///< The traversal function for the finest level
     FBoxWeight m_boxWeightFunc;  ///< The box weight function.
+    FBoxAggregate m_boxAggregateFunc;  ///< The box aggregation function.
+    FBoxLocal m_boxLocalFunc;  ///< The box local expansion function.
+    T m_tileLevel;  ///< The level of the tiles of the traversal.
+
+    template<class F>
+    /**
+     * \brief Divide [0, n) into a contiguous range for each thread, and
+     * call the function with each range in its own thread.
+     */
+    static void parallel_ranges(const size_t nThreads, const size_t n, const F& func) {
+        std::vector<std::thread> threads;
+        threads.reserve(nThreads);
+        for ( size_t t = 0; t < nThreads; ++t ) {
+            const T first = (n*t) / nThreads;
+            const T last = (n*(t+1)) / nThreads;
+            if ( first == last ) continue;
+            threads.emplace_back([&func, first, last]() {func(first, last);});
+        }
+        for ( auto& thread : threads ) {
+            thread.join();
+        }
+    }
+
+    /**
+     * \brief Find the coarsest level with at least one subtree per thread.
+     */
+    T split_level(const size_t nThreads) const {
+        const auto& dims = m_grid.get_dimensions();
+        T level = 0;
+        while (
+            level + 1 < dims.max_level() &&
+            box_stack_iterator<N, T>::n_subtrees(
+                dims, m_grid.get_subdivision_type(), level
+            ) < nThreads
+        ) {
+            ++level;
+        }
+        return level;
+    }
+
+    /**
+     * \brief A visitor which computes the box weight of each leaf, and
+     * aggregates the children of each box once its subtree is complete.
+     * 
+     * The stack of the boxes above the current box is kept as the tree is
+     * visited, and so each box is built once rather than once per leaf.
+     */
+    class upward_visitor {
+        fmm& m_fmm;  ///< The method.
+        box_stack<N, T> m_stack;  ///< The boxes from level 0 to the current box.
+
+     public:
+        explicit upward_visitor(fmm& method): m_fmm(method) {
+            if ( m_fmm.m_grid.get_dimensions().max_level() > box_stack<N, T>::m_capacity ) {
+                throw std::range_error("The maximum level is larger than the stack capacity");
+            }
+        }
+
+        /**
+         * \brief Add a box with children to the stack.
+         */
+        void on_enter(const compact_box<N, T>& boxVal) {
+            m_stack.push_back(boxVal);
+        }
+
+        /**
+         * \brief Compute the box weight of a leaf.
+         */
+        void on_leaf(const compact_box<N, T>& boxVal) {
+            m_stack.push_back(boxVal);
+            m_fmm.m_boxWeightFunc(m_stack, m_fmm.m_grid);
+            m_stack.pop_back();
+        }
+
+        /**
+         * \brief Aggregate the children of a box into it.
+         */
+        void on_exit(const compact_box<N, T>& boxVal) {
+            m_stack.pop_back();
+            m_fmm.m_boxAggregateFunc(m_fmm.m_grid.handle(boxVal), m_fmm.m_grid);
+        }
+    };
+
+    /**
+     * \brief Compute the box weights of the leaves, and aggregate them up
+     * the tree, in a single depth first pass.
+     * 
+     * Every box at the coarser levels is aggregated after the leaves of its
+     * subtree, and in the same order as the separate passes, so the result
+     * is the same.
+     */
+    void upward_pass() {
+        upward_visitor visitor(*this);
+        m_grid.visit(visitor);
+    }
+
+    /**
+     * \brief Compute the box weights of the leaves in parallel.
+     * 
+     * The stacks are partitioned between the threads by their subtree at
+     * the split level. The weight function only writes to the leaf of each
+     * stack, which is owned by one thread, and so the threads write to the
+     * grid directly.
+     */
+    void compute_box_weights(const size_t nThreads) {
+        const T splitLevel = split_level(nThreads);
+        const size_t nSubtrees = box_stack_iterator<N, T>::n_subtrees(
+            m_grid.get_dimensions(),
+            m_grid.get_subdivision_type(),
+            splitLevel
+        );
+        std::vector<std::thread> threads;
+        threads.reserve(nThreads);
+        for ( size_t t = 0; t < nThreads; ++t ) {
+            const T first = (nSubtrees*t) / nThreads;
+            const T last = (nSubtrees*(t+1)) / nThreads;
+            if ( first == last ) continue;
+            threads.emplace_back([&, first, last]() {
+                m_grid.iterate_subtrees(
+                    [&](const box_stack<N, T>& boxStack) {
+                        m_boxWeightFunc(boxStack, m_grid);
+                    },
+                    splitLevel,
+                    first,
+                    last
+                );
+            });
+        }
+        for ( auto& thread : threads ) {
+            thread.join();
+        }
+    }
+
+    /**
+     * \brief Aggregate the box weights from the finest level upwards.
+     * 
+     * Every box is computed from its children, once they are complete,
+     * and so the boxes of each level are independent of each other and
+     * are divided between the threads.
+     */
+    void aggregate_box_weights(const size_t nThreads) {
+        const auto& dims = m_grid.get_dimensions();
+        for ( T level = dims.max_level()-1; level > 0; --level ) {
+            const T parentLevel = level-1;
+            const size_t nBoxes = dims.max_ind(
+                parentLevel,
+                m_grid.get_subdivision_type(),
+                dimensions<N, T>::BOXES_MODE
+            );
+            const auto aggregate = [&](const T first, const T last) {
+                m_grid.iterate(
+                    [&](const box_handle<N, T>& parentBox) {
+                        m_boxAggregateFunc(parentBox, m_grid);
+                    },
+                    parentLevel,
+                    first,
+                    last
+                );
+            };
+            if ( nThreads <= 1 ) {
+                aggregate(0, nBoxes);
+            } else {
+                parallel_ranges(nThreads, nBoxes, aggregate);
+            }
+        }
+    }
+
+    /**
+     * \brief Compute the local expansions from the coarsest level downwards.
+     * 
+     * Every box is computed from its parent, once it is complete, and so
+     * the boxes of each level are independent of each other and are divided
+     * between the threads.
+     */
+    void compute_local_expansions(const size_t nThreads) {
+        const auto& dims = m_grid.get_dimensions();
+        for ( T level = 0; level < dims.max_level(); ++level ) {
+            const size_t nBoxes = dims.max_ind(
+                level,
+                m_grid.get_subdivision_type(),
+                dimensions<N, T>::BOXES_MODE
+            );
+            const auto local = [&](const T first, const T last) {
+                m_grid.iterate(
+                    [&](const box_handle<N, T>& boxVal) {
+                        m_boxLocalFunc(boxVal, m_grid);
+                    },
+                    level,
+                    first,
+                    last
+                );
+            };
+            if ( nThreads <= 1 ) {
+                local(0, nBoxes);
+            } else {
+                parallel_ranges(nThreads, nBoxes, local);
+            }
+        }
+    }
+
+    /**
+     * \brief Traverse every duel box at the finest level.
+     * 
+     * The duel boxes are traversed in tiles at the tile level, so that
+     * only a tile and its halo are in use at any time. In parallel the duel
+     * boxes are traversed one colour at a time, and each thread is given a
+     * range of the tiles, which are refined until there is a tile for every
+     * thread. Boxes of the same colour do not share any corners, and so the
+     * traversal function may write to the corners of its own box without
+     * synchronisation, provided that it keeps no other shared state.
+     */
+    void traverse(const size_t nThreads) {
+        const auto traversal = [&](const base_box<N, T>& boxElement) {
+            m_fineTraversalFunc(boxElement, m_grid);
+        };
+        if ( nThreads <= 1 ) {
+            m_grid.iterate_duel_tiles(traversal, m_tileLevel);
+            return;
+        }
+        const T tileLevel = std::max(m_tileLevel, split_level(nThreads));
+        for ( T colour = 0; colour < base_box<N, T>::m_nCorners; ++colour ) {
+            parallel_ranges(nThreads, m_grid.n_duel_tiles(tileLevel), [&](const T first, const T last) {
+                m_grid.iterate_duel_colour_tiles(traversal, colour, tileLevel, first, last);
+            });
+        }
+    }
 
  public:
+    static constexpr size_t m_tileBytes = size_t(1) << 20;  ///< The default bound of the working set of a tile, in bytes.
+
     fmm(
         const dimensions<N, T> dims,
         FTraversal fineTraversalFunc,
         FBoxWeight boxWeightFunc,
-        const subdivision_type subDiv
+        FBoxAggregate boxAggregateFunc,
+        FBoxLocal boxLocalFunc,
+        const subdivision_type subDiv,
+        const storage_layout layout = grid<N, GridElement, BoxElement, T>::ROW_MAJOR,
+        std::pmr::memory_resource* resource = std::pmr::get_default_resource()
     ) :
-        m_grid(dims, subDiv),
+        m_grid(dims, subDiv, layout, resource),
         m_fineTraversalFunc(fineTraversalFunc),
-        m_boxWeightFunc(boxWeightFunc) {}
+        m_boxWeightFunc(boxWeightFunc),
+        m_boxAggregateFunc(boxAggregateFunc),
+        m_boxLocalFunc(boxLocalFunc),
+        m_tileLevel(tile_level(m_tileBytes)) {}
+
+    /**
+     * \brief The coarsest tile level at which the working set of a tile
+     * fits in the specified number of bytes.
+     * 
+     * A tile covers w boxes at the finest level in each dimension. Its
+     * traversal reads those boxes and their neighbours, which are (w+2)^N
+     * boxes, and the (2w+4)^N points at their corners.
+     */
+    T tile_level(const size_t bytes) const {
+        const T leafLevel = m_grid.get_dimensions().max_level()-1;
+        for ( T level = 0; level < leafLevel; ++level ) {
+            const size_t width = size_t(1) << (leafLevel - level);
+            size_t nBoxes = 1;
+            size_t nPoints = 1;
+            for ( T d = 0; d < N; ++d ) {
+                nBoxes *= width + 2;
+                nPoints *= 2*width + 4;
+            }
+            if ( nBoxes*sizeof(BoxElement) + nPoints*sizeof(GridElement) <= bytes ) {
+                return level;
+            }
+        }
+        return leafLevel;
+    }
+
+    /**
+     * \brief Set the level of the tiles of the traversal.
+     * 
+     * By default it is the tile level of m_tileBytes.
+     */
+    void set_tile_level(const T level) {m_tileLevel = level;}
+
+    /**
+     * \brief Get the level of the tiles of the traversal.
+     */
+    T get_tile_level() const {return m_tileLevel;}
 
     /**
      * \brief Compute the solution.
      * 
-     * The algorithm iterates each level of the tree in coarse-to-fine and
-     * then at each of the finest nodes, reach back up to the coarsest levels
-     * to get the multipoles. In the fine-to-coarse traversal, the weights
-     * to each of the boxes are computed and stored.
+     * The algorithm iterates each level of the tree fine-to-coarse and then
+     * coarse-to-fine. In the fine-to-coarse traversal, the weights of the
+     * finest boxes are computed and stored, and every coarser box is aggregated
+     * from its children. In the coarse-to-fine traversal the local expansion
+     * of every box is computed, so that the finest boxes hold the whole far
+     * field. Finally each of the finest nodes is traversed. All traversals
+     * use the specified number of threads. With a single thread the
+     * fine-to-coarse traversal is one depth first visit of the tree.
      */
-    void compute() {
-        m_grid.iterate([&](const box_stack<N, T>& boxElement) {
-            m_boxWeightFunc(boxElement, m_grid);
-        });
-        m_grid.iterate([&](const base_box<N, T>& boxElement) {
-            m_fineTraversalFunc(boxElement, m_grid);
-        });
+    void compute(const size_t nThreads = 1) {
+        if ( nThreads <= 1 ) {
+            upward_pass();
+        } else {
+            compute_box_weights(nThreads);
+            aggregate_box_weights(nThreads);
+        }
+        compute_local_expansions(nThreads);
+        traverse(nThreads);
     }
 
+    /**
+     * \brief Reset the box values before the solution is recomputed.
+     * 
+     * The storage is reused, and so the tree is not reallocated.
+     */
+    void clear_boxes() {m_grid.clear_boxes();}
+
     size_t grid_size() const {return m_grid.size();}  ///< Get the number of vertices in the grid
+    std::span<const BoxElement> box_storage() const {return m_grid.box_storage();}  ///< Get the values of the boxes of every level
     GridElement& operator[](const T i) {return m_grid[i];}  ///< Access the ith vertex of the grid
     const GridElement& operator[](const T i) const {return m_grid[i];}  ///< Access the ith vertex of the grid
     GridElement& operator[](const index<N, T>& i) {return m_grid[i];}  ///< Access a vertex of the grid using an index
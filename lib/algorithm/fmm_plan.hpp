@@ -0,0 +1,212 @@
+// Copyright 2024 Daniel Beale CC BY-NC-SA 4.0
+#ifndef LIB_ALGORITHM_FMM_PLAN_HPP_
+#define LIB_ALGORITHM_FMM_PLAN_HPP_
+
+#include <inttypes.h>
+
+#include <array>
+#include <memory_resource>
+#include <vector>
+
+#include "base/dimensions.hpp"
+#include "base/box.hpp"
+#include "base/box_handle.hpp"
+#include "algorithm/interaction_list.hpp"
+#include "math/vector.hpp"
+
+namespace gs {
+template<int N, typename T, typename S = uint32_t>
+requires std::is_floating_point<T>::value && std::is_integral<S>::value && (N > 0)
+/**
+ * \brief The geometry of a multiplication on a grid.
+ *
+ * Everything which only depends on the dimensions of the grid: the
+ * position of every point, the center and radius of every box and the interaction
+ * lists. It is computed once and is immutable, and so a single plan can
+ * be shared by any number of multiplications on the same grid.
+ *
+ * The grid is a regular lattice, and so the positions are not stored. The
+ * position of a point is its subscript at the finest level, and the center
+ * of a box is an origin plus a spacing times its subscript at its level,
+ * both of which are kept for each level. The storage of the plan is then
+ * independent of the number of points, apart from the interaction lists,
+ * which are allocated from the memory resource of the plan.
+ * 
+ * The points and boxes are given by their position in the storage of a grid
+ * with the layout of the plan, as they are in the interaction lists, and the
+ * subscript is decoded from the position on each call.
+ *
+ * The template parameters,
+ *      N - The number of dimensions of the grid.
+ *      T - The floating point type of the positions.
+ *      S - The integral type.
+ */
+class fmm_plan {
+    using storage_layout = typename dimensions<N, S>::storage_layout;
+
+    interaction_list<N, S> m_interactions;  ///< The interaction lists of the grid.
+    std::array<S, N> m_pointDims;  ///< The dimensions of the points at the finest level.
+    std::vector<std::array<S, N>> m_boxDims;  ///< The dimensions of the boxes, per level.
+    std::vector<gs::vector<T, N>> m_origins;  ///< The center of the first box, per level.
+    std::vector<gs::vector<T, N>> m_spacings;  ///< The distance between adjacent box centers, per level.
+    std::vector<T> m_radii;  ///< The distance from the center of a box to its corners, per level.
+
+    /**
+     * \brief The center of a box, as the mean of its corners.
+     */
+    gs::vector<T, N> corner_mean(const dimensions<N, S>& dims, const S level, const S offset) const {
+        const S leafLevel = dims.max_level()-1;
+        const auto subDiv = dimensions<N, S>::BOXES_SUBDIVISION;
+        std::array<gs::vector<T, N>, base_box<N, S>::m_nCorners> corners;
+        const box<N, S> boxVal(dims, level, subDiv, offset);
+        for ( S k = 0; k < base_box<N, S>::m_nCorners; ++k ) {
+            corners[k] = gs::vector<T, N>(static_cast<const std::array<S, N>&>(boxVal[k].at_level(leafLevel, subDiv)));
+        }
+        return mean(corners);
+    }
+
+    /**
+     * \brief The subscript of a box or point at the specified level, from
+     * its position in storage.
+     */
+    std::array<S, N> subscript(
+        const S position,
+        const S level,
+        const std::array<S, N>& levelDims,
+        const typename dimensions<N, S>::modality mode
+    ) const {
+        if ( m_interactions.get_layout() == dimensions<N, S>::MORTON ) {
+            return get_dimensions().morton2sub(position, level, mode);
+        }
+        return dimensions<N, S>::ind2sub(position, levelDims);
+    }
+
+    /**
+     * \brief The center of the box with the specified subscript at a level.
+     */
+    gs::vector<T, N> subscript_center(const S level, const std::array<S, N>& sub) const {
+        gs::vector<T, N> center = m_origins[level];
+        for ( S d = 0; d < N; ++d ) {
+            center(d) += m_spacings[level](d)*static_cast<T>(sub[d]);
+        }
+        return center;
+    }
+
+ public:
+    static constexpr S m_nCorners = base_box<N, S>::m_nCorners;  ///< The number of corners of each box.
+
+    explicit fmm_plan(
+        const dimensions<N, S>& dims,
+        const storage_layout layout = dimensions<N, S>::ROW_MAJOR,
+        std::pmr::memory_resource* resource = std::pmr::get_default_resource()
+    ):
+        m_interactions(dims, layout, resource),
+        m_boxDims(dims.max_level()),
+        m_origins(dims.max_level()),
+        m_spacings(dims.max_level()),
+        m_radii(dims.max_level()) {
+        const S leafLevel = dims.max_level()-1;
+        const auto subDiv = dimensions<N, S>::BOXES_SUBDIVISION;
+        m_pointDims = dims.level_dims(leafLevel, subDiv, dimensions<N, S>::POINTS_MODE);
+
+        // The centers are affine in the subscript of the box, and so they
+        // are found from the first box and its neighbour in each dimension
+        for ( S level = 0; level < dims.max_level(); ++level ) {
+            m_boxDims[level] = dims.level_dims(level, subDiv, dimensions<N, S>::BOXES_MODE);
+            m_origins[level] = corner_mean(dims, level, 0);
+            S stride = 1;
+            for ( S i = 1; i <= N; ++i ) {
+                const S d = N-i;
+                if ( m_boxDims[level][d] > 1 ) {
+                    m_spacings[level](d) = (corner_mean(dims, level, stride) - m_origins[level])(d);
+                }
+                stride *= m_boxDims[level][d];
+            }
+            m_radii[level] = (
+                m_origins[level] - gs::vector<T, N>(static_cast<const std::array<S, N>&>(box<N, S>(dims, level, subDiv, 0)[0].at_level(leafLevel, subDiv)))
+            ).norm();
+        }
+    }
+
+    /**
+     * \brief Get the dimensions of the grid.
+     */
+    const dimensions<N, S>& get_dimensions() const {return m_interactions.get_dimensions();}
+
+    /**
+     * \brief Get the interaction lists of the grid.
+     */
+    const interaction_list<N, S>& get_interactions() const {return m_interactions;}
+
+    /**
+     * \brief Get the storage layout of the grid.
+     */
+    storage_layout get_layout() const {return m_interactions.get_layout();}
+
+    /**
+     * \brief The number of points in the grid.
+     */
+    size_t size() const {
+        size_t total = 1;
+        for ( const auto dim : m_pointDims ) total *= dim;
+        return total;
+    }
+
+    /**
+     * \brief The position of the point at the ith position in storage.
+     */
+    gs::vector<T, N> position(const S i) const {
+        return gs::vector<T, N>(subscript(i, m_boxDims.size()-1, m_pointDims, dimensions<N, S>::POINTS_MODE));
+    }
+
+    /**
+     * \brief The positions of the corners of a box at the finest level,
+     * in the order of its leaf_corners.
+     * 
+     * The subscript of the box is decoded once for all of its corners.
+     */
+    std::array<gs::vector<T, N>, m_nCorners> corner_positions(const S position) const {
+        const S leafLevel = m_boxDims.size()-1;
+        const auto sub = subscript(position, leafLevel, m_boxDims[leafLevel], dimensions<N, S>::BOXES_MODE);
+        std::array<gs::vector<T, N>, m_nCorners> corners;
+        for ( S k = 0; k < m_nCorners; ++k ) {
+            const auto unit = dimensions<N, S>::unitary(k);
+            for ( S d = 0; d < N; ++d ) {
+                corners[k](d) = static_cast<T>(2*sub[d] + unit[d]);
+            }
+        }
+        return corners;
+    }
+
+    /**
+     * \brief The center of the box at a position in storage of the
+     * specified level.
+     */
+    gs::vector<T, N> center(const S level, const S position) const {
+        return subscript_center(level, subscript(position, level, m_boxDims[level], dimensions<N, S>::BOXES_MODE));
+    }
+
+    /**
+     * \brief The distance from the center of a box at the specified level
+     * to its furthest point.
+     */
+    T radius(const S level) const {return m_radii[level];}
+
+    /**
+     * \brief The center of a box.
+     */
+    gs::vector<T, N> center(const box<N, S>& boxVal) const {
+        const S level = boxVal.get_level();
+        return subscript_center(level, dimensions<N, S>::ind2sub(boxVal.get_offset(), m_boxDims[level]));
+    }
+
+    /**
+     * \brief The center of a box handle.
+     */
+    gs::vector<T, N> center(const box_handle<N, S>& handle) const {
+        return center(handle.get_level(), handle.get_offset());
+    }
+};
+}  // namespace gs
+
+#endif  // LIB_ALGORITHM_FMM_PLAN_HPP_
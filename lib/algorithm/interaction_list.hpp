@@ -0,0 +1,355 @@
+// Copyright 2024 Daniel Beale CC BY-NC-SA 4.0
+#ifndef LIB_ALGORITHM_INTERACTION_LIST_HPP_
+#define LIB_ALGORITHM_INTERACTION_LIST_HPP_
+
+#include <inttypes.h>
+#include <span>
+
+#include <algorithm>
+#include <array>
+#include <memory_resource>
+#include <vector>
+
+#include "base/dimensions.hpp"
+#include "base/box.hpp"
+#include "base/base_box.hpp"
+#include "base/box_duel_iterator.hpp"
+
+namespace gs {
+template<int N, typename T = uint32_t>
+requires std::is_integral<T>::value && std::is_unsigned<T>::value && (N > 0)
+/**
+ * \brief The interaction lists of the grid.
+ *
+ * The traversal of a duel box adds the contribution of every point in
+ * the grid to each of its corners (the targets). The box at the finest
+ * level which contains a target is its leaf. The points in the leaf and
+ * in its adjacent leaves are added exactly, and are the near field.
+ *
+ * The remainder of the grid is the far field, and is covered by the
+ * interaction lists of the leaf and of its ancestors. The interaction list
+ * of a box contains the children of the neighbours of its parent which are
+ * not adjacent to the box itself, so that every box in the list is separated
+ * from the box by at least one box of the same size. The far field is
+ * gathered into a local expansion for each box, which is passed down to its
+ * children, and so each target only evaluates the expansion of its leaf.
+ *
+ * Since the lists only depend on the dimensions of the grid, they are
+ * computed once and stored as flat arrays. Every point and box is given by
+ * its position in the storage of the grid, with the layout of the grid, so
+ * that the traversal reads the grid without converting each index. The
+ * neighbours and interaction lists are stored in compressed rows indexed by
+ * the position of the box. In the row-major layout the duel boxes are
+ * numbered in the order of the box_duel_iterator. In the Morton layout they
+ * are numbered by the position of the box at the finest level which holds
+ * their first corner, as they are visited by the grid, and the numbers of
+ * the boxes in the last row of each dimension are unused.
+ *
+ * The tables hold several entries for each point of the grid, and so, like
+ * the grid, they are allocated from a memory resource, which must outlive
+ * the lists.
+ *
+ * The template parameters,
+ *      N - The number of dimensions of the grid.
+ *      T - The integral type.
+ */
+class interaction_list {
+    using storage_layout = typename dimensions<N, T>::storage_layout;
+
+ public:
+    static constexpr T m_nCorners = base_box<N, T>::m_nCorners;  ///< The number of corners of each box.
+
+ private:
+    dimensions<N, T> m_dimensions;  ///< The dimensions of the grid.
+    storage_layout m_layout;  ///< The storage layout of the grid.
+    std::array<T, N> m_nDuelBoxes;  ///< The number of duel boxes in each dimension.
+    std::pmr::vector<T> m_targets;  ///< The position of the corners of each duel box.
+    std::pmr::vector<T> m_leaves;  ///< The position of the leaf of each corner of each duel box.
+    std::pmr::vector<T> m_leafCorners;  ///< The position of the corners of each finest box.
+    std::pmr::vector<T> m_neighbourStart;  ///< The start of each finest box in the neighbours.
+    std::pmr::vector<T> m_neighbours;  ///< The positions of the boxes adjacent to each finest box.
+    std::pmr::vector<std::pmr::vector<T>> m_farStart;  ///< The start of each box in the interaction lists, per level.
+    std::pmr::vector<std::pmr::vector<T>> m_far;  ///< The positions of the boxes in the interaction lists, per level.
+
+    /**
+     * \brief The position in storage of a point.
+     */
+    T point_position(const index<N, T>& ind) const {
+        const T leafLevel = m_dimensions.max_level()-1;
+        const auto sub = ind.at_level(leafLevel, dimensions<N, T>::BOXES_SUBDIVISION);
+        if ( m_layout == dimensions<N, T>::MORTON ) {
+            return m_dimensions.sub2morton(sub, leafLevel);
+        }
+        return m_dimensions.sub2ind(sub, leafLevel, dimensions<N, T>::BOXES_SUBDIVISION, dimensions<N, T>::POINTS_MODE);
+    }
+
+    /**
+     * \brief The position in storage of a box, from its row-major offset.
+     */
+    T box_position(const T level, const T offset) const {
+        if ( m_layout == dimensions<N, T>::MORTON ) {
+            return m_dimensions.sub2morton(box_index(level, offset), level, dimensions<N, T>::BOXES_MODE);
+        }
+        return offset;
+    }
+
+    /**
+     * \brief The row-major offset of a box, from its position in storage.
+     */
+    T box_offset(const T level, const T position) const {
+        if ( m_layout == dimensions<N, T>::MORTON ) {
+            return m_dimensions.sub2ind(
+                m_dimensions.morton2sub(position, level, dimensions<N, T>::BOXES_MODE),
+                level,
+                dimensions<N, T>::BOXES_SUBDIVISION,
+                dimensions<N, T>::BOXES_MODE
+            );
+        }
+        return position;
+    }
+
+    /**
+     * \brief The position of a box in the boxes at its level.
+     */
+    std::array<T, N> box_index(const T level, const T offset) const {
+        return m_dimensions.ind2sub(
+            offset,
+            level,
+            dimensions<N, T>::BOXES_SUBDIVISION,
+            dimensions<N, T>::BOXES_MODE
+        );
+    }
+
+    /**
+     * \brief The offsets of the boxes adjacent to a box, including itself.
+     */
+    std::vector<T> adjacent(const T level, const T offset) const {
+        const auto levelDims = m_dimensions.level_dims(
+            level,
+            dimensions<N, T>::BOXES_SUBDIVISION,
+            dimensions<N, T>::BOXES_MODE
+        );
+        const auto boxIndex = box_index(level, offset);
+        std::vector<T> offsets;
+        for ( T i = 0; i < pow<3, N>(); ++i ) {
+            // Step by -1, 0 or 1 in each dimension
+            std::array<T, N> nbrIndex;
+            bool inside = true;
+            T remainder = i;
+            for ( T d = 0; d < N; ++d ) {
+                // A step below zero wraps around, and so is outside
+                nbrIndex[d] = boxIndex[d] + (remainder % 3) - 1;
+                inside &= nbrIndex[d] < levelDims[d];
+                remainder /= 3;
+            }
+            if ( inside ) {
+                offsets.push_back(m_dimensions.sub2ind(
+                    nbrIndex,
+                    level,
+                    dimensions<N, T>::BOXES_SUBDIVISION,
+                    dimensions<N, T>::BOXES_MODE
+                ));
+            }
+        }
+        return offsets;
+    }
+
+    /**
+     * \brief True if two boxes at the same level are not adjacent.
+     */
+    bool separated(const T level, const T offsetA, const T offsetB) const {
+        const auto indexA = box_index(level, offsetA);
+        const auto indexB = box_index(level, offsetB);
+        for ( T d = 0; d < N; ++d ) {
+            if ( indexA[d] > indexB[d] + 1 || indexB[d] > indexA[d] + 1 ) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * \brief The positions of the boxes in the interaction list of a box.
+     *
+     * The boxes at the coarsest level have no parent, and so every
+     * other box at that level is a candidate.
+     */
+    std::vector<T> interactions(const T level, const T offset) const {
+        const auto subDiv = dimensions<N, T>::BOXES_SUBDIVISION;
+        std::vector<T> candidates;
+        if ( level == 0 ) {
+            const T nBoxes = m_dimensions.max_ind(0, subDiv, dimensions<N, T>::BOXES_MODE);
+            for ( T i = 0; i < nBoxes; ++i ) {
+                candidates.push_back(i);
+            }
+        } else {
+            const auto parentBox = box<N, T>(m_dimensions, level, subDiv, offset).parent();
+            for ( const auto nbrOffset : adjacent(level-1, parentBox.get_offset()) ) {
+                const box<N, T> nbrBox(m_dimensions, level-1, subDiv, nbrOffset);
+                for ( T k = 0; k < m_nCorners; ++k ) {
+                    candidates.push_back(nbrBox.subbox(k).get_offset());
+                }
+            }
+        }
+        std::vector<T> positions;
+        for ( const auto candidate : candidates ) {
+            if ( separated(level, offset, candidate) ) {
+                positions.push_back(box_position(level, candidate));
+            }
+        }
+        return positions;
+    }
+
+ public:
+    explicit interaction_list(
+        const dimensions<N, T>& dims,
+        const storage_layout layout = dimensions<N, T>::ROW_MAJOR,
+        std::pmr::memory_resource* resource = std::pmr::get_default_resource()
+    ):
+        m_dimensions(dims),
+        m_layout(layout),
+        m_nDuelBoxes(box_duel_iterator<N, T>::n_duel_boxes(dims, dims.max_level()-1)),
+        m_targets(resource),
+        m_leaves(resource),
+        m_leafCorners(resource),
+        m_neighbourStart(resource),
+        m_neighbours(resource),
+        m_farStart(dims.max_level(), resource),
+        m_far(dims.max_level(), resource) {
+        const T leafLevel = m_dimensions.max_level()-1;
+        const auto subDiv = dimensions<N, T>::BOXES_SUBDIVISION;
+
+        // The corners and neighbours of every box at the finest level. The
+        // rows are counted first, so that each table is a single allocation.
+        const T nLeaves = m_dimensions.max_ind(leafLevel, subDiv, dimensions<N, T>::BOXES_MODE);
+        m_leafCorners.resize(nLeaves*m_nCorners);
+        m_neighbourStart.resize(nLeaves+1, 0);
+        for ( T i = 0; i < nLeaves; ++i ) {
+            m_neighbourStart[i+1] = m_neighbourStart[i] + adjacent(leafLevel, box_offset(leafLevel, i)).size();
+        }
+        m_neighbours.resize(m_neighbourStart[nLeaves]);
+        for ( T i = 0; i < nLeaves; ++i ) {
+            const T offset = box_offset(leafLevel, i);
+            T k = i*m_nCorners;
+            for ( const auto& corner : box<N, T>(m_dimensions, leafLevel, subDiv, offset) ) {
+                m_leafCorners[k++] = point_position(corner);
+            }
+            k = m_neighbourStart[i];
+            for ( const auto nbrOffset : adjacent(leafLevel, offset) ) {
+                m_neighbours[k++] = box_position(leafLevel, nbrOffset);
+            }
+        }
+
+        // The interaction list of every box
+        for ( T level = 0; level < m_dimensions.max_level(); ++level ) {
+            const T nBoxes = m_dimensions.max_ind(level, subDiv, dimensions<N, T>::BOXES_MODE);
+            m_farStart[level].resize(nBoxes+1, 0);
+            for ( T i = 0; i < nBoxes; ++i ) {
+                m_farStart[level][i+1] = m_farStart[level][i] + interactions(level, box_offset(level, i)).size();
+            }
+            m_far[level].resize(m_farStart[level][nBoxes]);
+            for ( T i = 0; i < nBoxes; ++i ) {
+                const auto positions = interactions(level, box_offset(level, i));
+                std::copy(positions.begin(), positions.end(), m_far[level].begin() + m_farStart[level][i]);
+            }
+        }
+
+        // The targets of every duel box, and their leaves
+        const T nNumbers = (m_layout == dimensions<N, T>::MORTON) ? nLeaves : n_duel_boxes();
+        m_targets.resize(nNumbers*m_nCorners);
+        m_leaves.resize(nNumbers*m_nCorners);
+        for (
+            auto duelIt = box_duel_iterator<N, T>(m_dimensions, leafLevel);
+            duelIt < box_duel_iterator<N, T>(m_dimensions, leafLevel, true);
+            ++duelIt
+        ) {
+            const T duel = duel_number(*duelIt);
+            for ( T i = 0; i < m_nCorners; ++i ) {
+                m_targets[duel*m_nCorners + i] = point_position((*duelIt)[i]);
+                m_leaves[duel*m_nCorners + i] = box_position(
+                    leafLevel,
+                    box<N, T>(m_dimensions, (*duelIt)[i], subDiv).get_offset()
+                );
+            }
+        }
+    }
+
+    /**
+     * \brief Get the dimensions of the grid.
+     */
+    const dimensions<N, T>& get_dimensions() const {return m_dimensions;}
+
+    /**
+     * \brief Get the storage layout of the grid.
+     */
+    storage_layout get_layout() const {return m_layout;}
+
+    /**
+     * \brief The total number of duel boxes.
+     */
+    T n_duel_boxes() const {
+        T total = 1;
+        for ( const auto nBoxes : m_nDuelBoxes ) total *= nBoxes;
+        return total;
+    }
+
+    /**
+     * \brief The number of the duel box.
+     */
+    T duel_number(const base_box<N, T>& duelBox) const {
+        if ( m_layout == dimensions<N, T>::MORTON ) {
+            std::array<T, N> leafIndex = duelBox[0];
+            for ( auto& ind : leafIndex ) ind /= 2;
+            return m_dimensions.sub2morton(leafIndex, m_dimensions.max_level()-1, dimensions<N, T>::BOXES_MODE);
+        }
+        T number = 0;
+        T coef = 1;
+        for ( T d = 0; d < N; ++d ) {
+            number += coef*(duelBox[0][d] / 2);
+            coef *= m_nDuelBoxes[d];
+        }
+        return number;
+    }
+
+    /**
+     * \brief The position of each of the corners of a duel box.
+     */
+    std::span<const T, m_nCorners> targets(const T duel) const {
+        return std::span<const T, m_nCorners>(m_targets.data() + duel*m_nCorners, m_nCorners);
+    }
+
+    /**
+     * \brief The position of the leaf of each of the corners of a duel box.
+     */
+    std::span<const T, m_nCorners> leaves(const T duel) const {
+        return std::span<const T, m_nCorners>(m_leaves.data() + duel*m_nCorners, m_nCorners);
+    }
+
+    /**
+     * \brief The position of each of the corners of a box at the finest level.
+     */
+    std::span<const T, m_nCorners> leaf_corners(const T position) const {
+        return std::span<const T, m_nCorners>(m_leafCorners.data() + position*m_nCorners, m_nCorners);
+    }
+
+    /**
+     * \brief The positions of the boxes adjacent to a box at the finest
+     * level, including the box itself.
+     */
+    std::span<const T> neighbours(const T position) const {
+        const T start = m_neighbourStart[position];
+        return std::span<const T>(m_neighbours.data() + start, m_neighbourStart[position+1] - start);
+    }
+
+    /**
+     * \brief The positions of the boxes in the interaction list of a box
+     * at the specified level.
+     */
+    std::span<const T> far(const T level, const T position) const {
+        const T start = m_farStart[level][position];
+        return std::span<const T>(m_far[level].data() + start, m_farStart[level][position+1] - start);
+    }
+};
+}  // namespace gs
+
+#endif  // LIB_ALGORITHM_INTERACTION_LIST_HPP_
@@ -39,19 +39,20 @@ class box: public base_box<N, T> {
      * 
      * This method is called on construction, and stored in the
      * m_indexInParent variable. It is therefore private.
+     * 
+     * The first corner holds the subscript of the box, which is doubled
+     * in the boxes subdivision, and so the offset is not converted again.
      */
     T compute_index_in_parent() const {
         if ( base_box<N, T>::m_level > 0 ) {
-            // Convert the index vector into local box coordinate
+            // Convert the first corner into a local box coordinate
+            std::array<T, N> local = static_cast<std::array<T, N>>(base_box<N, T>::m_corners[0]);
+            for ( auto& ind : local ) {
+                if ( m_subdivType == dimensions<N, T>::BOXES_SUBDIVISION ) ind >>= 1;
+                ind %= 2;
+            }
             return base_box<N, T>::m_dimensions.sub2ind(
-                // Convert the offset into a local box coordinate.
-                base_box<N, T>::m_dimensions.ind2sub(
-                    m_offset,
-                    base_box<N, T>::m_level,
-                    m_subdivType,
-                    dimensions<N, T>::BOXES_MODE,
-                    dimensions<N, T>::LOCAL_CONV
-                ),
+                local,
                 base_box<N, T>::m_level - 1,
                 m_subdivType,
                 dimensions<N, T>::LOCAL_BOXES
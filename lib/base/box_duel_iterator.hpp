@@ -77,6 +77,34 @@ class box_duel_iterator {
             for ( auto& dim : m_levelDims ) { --dim; }
         }
 
+    /**
+     * \brief The number of duel boxes in each dimension at the
+     * iteration level.
+     */
+    static std::array<T, N> n_duel_boxes(const dimensions<N, T>& dims, const T iterationLevel) {
+        std::array<T, N> nBoxes(dims.level_dims(
+            iterationLevel,
+            dimensions<N, T>::BOXES_SUBDIVISION,
+            dimensions<N, T>::POINTS_MODE
+        ));
+        // Each duel box starts on an odd point, and takes two points
+        // in each dimension, apart from the first and last.
+        for ( auto& dim : nBoxes ) { dim = (dim > 2) ? (dim - 2) / 2 : 0; }
+        return nBoxes;
+    }
+
+    /**
+     * \brief The duel box at the specified subscript, in units of duel boxes.
+     */
+    static base_box<N, T> duel_box(
+        const dimensions<N, T>& dims,
+        const T iterationLevel,
+        std::array<T, N> duelIndex
+    ) {
+        for ( auto& ind : duelIndex ) { ind = 2*ind + 1; }
+        return base_box<N, T>(dims, index<N, T>(duelIndex, iterationLevel));
+    }
+
     /**
      * \brief Increment the iterator by 1 and return
      * the incremented object.
@@ -0,0 +1,124 @@
+// Copyright 2024 Daniel Beale CC BY-NC-SA 4.0
+#ifndef LIB_BASE_BOX_HANDLE_HPP_
+#define LIB_BASE_BOX_HANDLE_HPP_
+
+#include <array>
+
+#include "base/dimensions.hpp"
+#include "base/box.hpp"
+
+namespace gs {
+template<int N, typename T = uint32_t>
+requires std::is_integral<T>::value && std::is_unsigned<T>::value
+/**
+ * \brief A box in the grid, identified by its level and offset.
+ *
+ * A box stores its dimensions and the 2^N indices of its corners, each of
+ * which stores the dimensions again, and so it is expensive to construct.
+ * The handle is only the level and offset of the box. It is navigated with
+ * the dimensions and subdivision of the grid, which are passed to each
+ * method rather than stored, and so the navigation is integer arithmetic
+ * on the index at the level. The corners are only found when the handle
+ * is converted into a box.
+ *
+ * The navigation matches that of the box: the parent of a box at level 0
+ * is itself, and its neighbours are the other boxes at level 0.
+ *
+ * The offset is the position of the box in the storage of its level. The
+ * methods of the handle navigate the row-major layout, in which that is the
+ * row-major offset, and the grid navigates the handles of either layout.
+ *
+ * The template parameters,
+ *      N - The number of dimensions of the box
+ *      T - The integral type.
+ */
+class box_handle {
+    using subdivision_type = typename dimensions<N, T>::subdivision_type;
+
+    T m_level;  ///< The box level.
+    T m_offset;  ///< The box index (offset).
+
+ public:
+    static constexpr T m_nCorners = pow<2, N>();  ///< The number of corners.
+
+    box_handle(): m_level(0), m_offset(0) {}
+    box_handle(const T level, const T offset): m_level(level), m_offset(offset) {}
+
+    T get_level() const {return m_level;}  ///< Get the box level.
+    T get_offset() const {return m_offset;}  ///< Get the box offset.
+
+    /**
+     * \brief The index of the box within its parent box.
+     */
+    T index_in_parent(const dimensions<N, T>& dims, const subdivision_type subDiv) const {
+        if ( m_level == 0 ) {
+            return 0;
+        }
+        return dims.sub2ind(
+            dims.ind2sub(m_offset, m_level, subDiv, dimensions<N, T>::BOXES_MODE, dimensions<N, T>::LOCAL_CONV),
+            m_level - 1,
+            subDiv,
+            dimensions<N, T>::LOCAL_BOXES
+        );
+    }
+
+    /**
+     * \brief The parent of the box, or the box itself at level 0.
+     */
+    box_handle<N, T> parent(const dimensions<N, T>& dims, const subdivision_type subDiv) const {
+        if ( m_level == 0 ) {
+            return *this;
+        }
+        auto boxIndex = dims.ind2sub(m_offset, m_level, subDiv, dimensions<N, T>::BOXES_MODE);
+        // There are a factor of two more boxes at the next level
+        for ( auto& i : boxIndex ) i /= 2;
+        return box_handle<N, T>(
+            m_level - 1,
+            dims.sub2ind(boxIndex, m_level - 1, subDiv, dimensions<N, T>::BOXES_MODE)
+        );
+    }
+
+    /**
+     * \brief The subbox after binary subdivision, in the direction of
+     * the specified corner.
+     */
+    box_handle<N, T> subbox(const T ind, const dimensions<N, T>& dims, const subdivision_type subDiv) const {
+        auto boxIndex = dims.ind2sub(m_offset, m_level, subDiv, dimensions<N, T>::BOXES_MODE);
+        const auto unit = dimensions<N, T>::unitary(ind);
+        for ( size_t i = 0; i < N; ++i ) {
+            boxIndex[i] = 2*boxIndex[i] + unit[i];
+        }
+        return box_handle<N, T>(
+            m_level + 1,
+            dims.sub2ind(boxIndex, m_level + 1, subDiv, dimensions<N, T>::BOXES_MODE)
+        );
+    }
+
+    /**
+     * \brief The neighbour of the box within its parent, or the box with
+     * the specified offset at level 0.
+     */
+    box_handle<N, T> neighbour(const T ind, const dimensions<N, T>& dims, const subdivision_type subDiv) const {
+        if ( m_level == 0 ) {
+            return box_handle<N, T>(0, ind);
+        }
+        return parent(dims, subDiv).subbox(ind, dims, subDiv);
+    }
+
+    /**
+     * \brief Construct the box, with its corners.
+     */
+    box<N, T> to_box(const dimensions<N, T>& dims, const subdivision_type subDiv) const {
+        return box<N, T>(dims, m_level, subDiv, m_offset);
+    }
+
+    /**
+     * \brief Return true if the handles are the same box.
+     */
+    bool operator==(const box_handle<N, T>& other) const {
+        return m_level == other.m_level && m_offset == other.m_offset;
+    }
+};
+}  // namespace gs
+
+#endif  // LIB_BASE_BOX_HANDLE_HPP_
@@ -4,38 +4,99 @@
 
 #include <compare>
 
-#include <vector>
+#include <algorithm>
+#include <array>
+#include <stdexcept>
 
-#include "base/box.hpp"
+#include "base/compact_box.hpp"
 
 namespace gs {
-template<int N, typename T = uint32_t>
-requires std::is_integral<T>::value && std::is_unsigned<T>::value && (N > 0)
+template<int N, typename T = uint32_t, size_t C = 24>
+requires std::is_integral<T>::value && std::is_unsigned<T>::value && (N > 0) && (C > 0)
 /**
  * \brief The stack of boxes.
+ * 
+ * The boxes are compact, and refer to the dimensions of the grid. They
+ * are stored inline, up to the capacity, and so the stack is copied
+ * without allocating. A grid deeper than the capacity is rejected by the
+ * iterator with a range_error.
+ *
+ * The template parameters,
+ *      N - The number of dimensions of the boxes
+ *      T - The integral type.
+ *      C - The largest number of levels.
  */
-using box_stack = std::vector<box<N, T>>;
+class box_stack {
+ public:
+    static constexpr size_t m_capacity = C;  ///< The largest number of levels.
+
+ private:
+    std::array<compact_box<N, T>, m_capacity> m_boxes;  ///< The boxes, coarsest first.
+    size_t m_size;  ///< The number of boxes.
+
+ public:
+    box_stack(): m_boxes{}, m_size(0) {}
+
+    size_t size() const {return m_size;}  ///< The number of boxes.
+    bool empty() const {return m_size == 0;}  ///< Whether the stack is empty.
+    void clear() {m_size = 0;}  ///< Remove every box.
+
+    /**
+     * \brief Add a box at the next level.
+     */
+    void push_back(const compact_box<N, T>& boxVal) {
+        DEBUG_ASSERT(m_size < m_capacity)
+        m_boxes[m_size++] = boxVal;
+    }
+
+    /**
+     * \brief Remove the finest box.
+     */
+    void pop_back() {
+        DEBUG_ASSERT(m_size > 0)
+        --m_size;
+    }
 
-template<int N, typename T = uint32_t>
-requires std::is_integral<T>::value && std::is_unsigned<T>::value && (N > 0)
+    compact_box<N, T>& operator[](const size_t i) {return m_boxes[i];}  ///< Access the ith box.
+    const compact_box<N, T>& operator[](const size_t i) const {return m_boxes[i];}  ///< Access the ith box.
+    const compact_box<N, T>& back() const {return m_boxes[m_size-1];}  ///< Access the finest box.
+    auto begin() const -> decltype(m_boxes.begin()) {return m_boxes.begin();}  ///< Return a begin iterator into the boxes
+    auto end() const -> decltype(m_boxes.begin()) {return m_boxes.begin() + m_size;}  ///< Return the end iterator into the boxes
+};
+
+template<int N, typename T = uint32_t, size_t C = 24>
+requires std::is_integral<T>::value && std::is_unsigned<T>::value && (N > 0) && (C > 0)
 /**
  * \brief An iterator over a stack of boxes.
  * 
- * The grid is a heirarchy of boxes. To avoid overuse of the
- * stack itself the boxes are stored on the heap as a vector,
- * one for each level of the heirarchy. The stack is iterated
- * by counting the number of increments at each level.
+ * The grid is a heirarchy of boxes. The iterator holds one box
+ * and one count for each level of the heirarchy, in arrays of the
+ * fixed capacity C, and so it is stored inline and does not
+ * allocate when it is constructed, copied or incremented. The
+ * constructor throws a range_error if the grid has more than C
+ * levels. The stack is iterated by counting the number of
+ * increments at each level, and each increment only rebuilds the
+ * boxes below the coarsest changed count.
  * 
  * The box_stack_iterator works as an iterator over the whole
  * stack, and so * casts to the stack itself. It can also be
  * incremented.
+ * 
+ * The boxes of the stack refer to the dimensions which the iterator
+ * is constructed with, and so the dimensions must outlive the iterator
+ * and its stacks.
+ *
+ * The template parameters,
+ *      N - The number of dimensions of the boxes
+ *      T - The integral type.
+ *      C - The largest number of levels.
  */
 class box_stack_iterator {
     using subdivision_type = typename dimensions<N, T>::subdivision_type;
 
-    dimensions<N, T> m_dimensions;  ///< The dimensions of the grid
-    box_stack<N, T> m_stack;  ///< The stack of boxes
-    std::vector<T> m_counts;  ///< The counts
+    const dimensions<N, T>* m_dimensions;  ///< The dimensions of the grid
+    box_stack<N, T, C> m_stack;  ///< The stack of boxes
+    std::array<T, C> m_counts;  ///< The counts
     T m_firstBoxMax;  ///< Max index of the first box (it not a subbox)
     T m_maxLevel;  ///< The maximum level
     subdivision_type m_subDivType;  ///< The subdivision type
@@ -74,23 +135,25 @@ class box_stack_iterator {
         const subdivision_type
         subDiv,
         const bool past_end = false):
-        m_dimensions(dims),
-        m_counts(dims.max_level(), 0),
+        m_dimensions(&dims),
+        m_counts{},
         m_firstBoxMax(dims.max_ind(0, subDiv, dimensions<N, T>::BOXES_MODE)),
         m_maxLevel(dims.max_level()),
         m_subDivType(subDiv) {
+        if ( m_maxLevel > C ) {
+            throw std::range_error("The maximum level is larger than the stack capacity");
+        }
         const T start_offset = 0;
+        m_counts.fill(0);
         if ( past_end ) {
             m_counts[0] = m_firstBoxMax;
         } else {
-            m_stack.reserve(m_maxLevel);
             for ( size_t level = 0; level < m_maxLevel; ++level ) {
                 m_stack.push_back(
-                    box<N, T>(
-                        m_dimensions,
+                    compact_box<N, T>(
+                        *m_dimensions,
                         level,
                         subDiv,
-                        start_offset,
                         start_offset
                     )
                 );
@@ -98,20 +161,79 @@ class box_stack_iterator {
         }
     }
 
+    /**
+     * \brief Construct the iterator at the first stack of a subtree.
+     *
+     * The subtrees are rooted at the specified level, and are numbered in
+     * the order that the iterator visits them, so that the stacks of a
+     * contiguous range of subtrees are a contiguous range of the iteration.
+     * Passing n_subtrees(...) as the subtree gives the past-the-end iterator.
+     */
+    box_stack_iterator(
+        const dimensions<N, T>& dims,
+        const subdivision_type subDiv,
+        const T subtree,
+        const T subtreeLevel
+    ): box_stack_iterator(dims, subDiv, true) {
+        DEBUG_ASSERT(subtreeLevel < m_maxLevel)
+        if ( subtree >= n_subtrees(dims, subDiv, subtreeLevel) ) {
+            return;
+        }
+        // Convert the subtree number into the counts at each level
+        T remainder = subtree;
+        for ( T level = subtreeLevel; level > 0; --level ) {
+            m_counts[level] = remainder % m_nSubBoxes;
+            remainder /= m_nSubBoxes;
+        }
+        m_counts[0] = remainder;
+        m_stack.push_back(
+            compact_box<N, T>(
+                *m_dimensions,
+                0,
+                m_subDivType,
+                m_counts[0]
+            )
+        );
+        for ( size_t level = 1; level < m_maxLevel; ++level ) {
+            m_stack.push_back(m_stack[level-1].subbox(m_counts[level]));
+        }
+    }
+
+    /**
+     * \brief The iterator only holds the address of the dimensions, and so
+     * it cannot be constructed from a temporary.
+     */
+    box_stack_iterator(const dimensions<N, T>&&, const subdivision_type, const bool = false) = delete;
+    box_stack_iterator(const dimensions<N, T>&&, const subdivision_type, const T, const T) = delete;
+
+    /**
+     * \brief The number of subtrees rooted at the specified level.
+     */
+    static T n_subtrees(
+        const dimensions<N, T>& dims,
+        const subdivision_type subDiv,
+        const T level
+    ) {
+        T nSubtrees = dims.max_ind(0, subDiv, dimensions<N, T>::BOXES_MODE);
+        for ( T i = 0; i < level; ++i ) {
+            nSubtrees *= m_nSubBoxes;
+        }
+        return nSubtrees;
+    }
+
     /**
      * \brief Increment the iterator by 1 and return
      * the incremented object.
      */
-    box_stack_iterator<N, T>& operator++() {
+    box_stack_iterator<N, T, C>& operator++() {
         T firstChangedIndex = increment_counts();
-        if ( m_counts[0] < m_nSubBoxes ) {
+        if ( m_counts[0] < m_firstBoxMax ) {
             for ( size_t i = firstChangedIndex; i < m_maxLevel; ++i ) {
                 if ( i == 0 ) {
-                    m_stack[i] = box<N, T>(
-                        m_dimensions,
+                    m_stack[i] = compact_box<N, T>(
+                        *m_dimensions,
                         0,
                         m_subDivType,
-                        m_counts[0],
                         m_counts[0]
                     );
                 } else {
@@ -128,24 +250,24 @@ class box_stack_iterator {
      * \brief increment the iterator by 1 but return the
      * object before it was incremented.
      */
-    box_stack_iterator<N, T> operator++(int) {
-        box_stack_iterator<N, T> self(*this);
-        box_stack_iterator<N, T>::operator++();
+    box_stack_iterator<N, T, C> operator++(int) {
+        box_stack_iterator<N, T, C> self(*this);
+        box_stack_iterator<N, T, C>::operator++();
         return self;
     }
 
     /**
      * \brief Equality for the iterator
      */
-    bool operator==(const box_stack_iterator<N, T>& other) const {
-        return m_counts == other.m_counts;
+    bool operator==(const box_stack_iterator<N, T, C>& other) const {
+        return std::equal(m_counts.begin(), m_counts.begin() + m_maxLevel, other.m_counts.begin());
     }
 
     /**
      * \brief Partial ordering for the iterator.
      */
     std::partial_ordering operator<=>(
-        const box_stack_iterator<N, T>& other
+        const box_stack_iterator<N, T, C>& other
     ) const {
         for ( size_t i = 0; i < m_maxLevel; ++i ) {
             if ( m_counts[i] < other.m_counts[i] ) {
@@ -157,19 +279,19 @@ class box_stack_iterator {
         return std::partial_ordering::equivalent;
     }
 
-    const box_stack<N, T>& operator*() {return m_stack;}  ///< Access the underlying stack
-    operator const box_stack<N, T>& () const {return m_stack;}  ///< Access the underlying stack
+    const box_stack<N, T, C>& operator*() {return m_stack;}  ///< Access the underlying stack
+    operator const box_stack<N, T, C>& () const {return m_stack;}  ///< Access the underlying stack
 
-    template<int M, typename S>
-    friend std::ostream& operator<<(std::ostream& os, const box_stack_iterator<M, S>& it);
+    template<int M, typename S, size_t D>
+    friend std::ostream& operator<<(std::ostream& os, const box_stack_iterator<M, S, D>& it);
 };
 
-template<int N, typename T = uint32_t>
+template<int N, typename T = uint32_t, size_t C = 24>
 /**
  * \brief Append the iterator to an output stream.
  */
-std::ostream& operator<<(std::ostream& os, const box_stack_iterator<N, T>& it) {
-    const size_t M = it.m_counts.size();
+std::ostream& operator<<(std::ostream& os, const box_stack_iterator<N, T, C>& it) {
+    const size_t M = it.m_maxLevel;
     os << "[";
     for ( size_t i = 0; i < M-1; ++i ) {
         os << it.m_counts[i] << ",";
@@ -0,0 +1,199 @@
+// Copyright 2024 Daniel Beale CC BY-NC-SA 4.0
+#ifndef LIB_BASE_COMPACT_BOX_HPP_
+#define LIB_BASE_COMPACT_BOX_HPP_
+
+#include <array>
+
+#include "base/dimensions.hpp"
+#include "base/index.hpp"
+#include "base/tools.hpp"
+#include "base/box.hpp"
+#include "base/box_handle.hpp"
+
+namespace gs {
+template<int N, typename T = uint32_t>
+requires std::is_integral<T>::value && std::is_unsigned<T>::value && (N > 0)
+/**
+ * \brief A box in the grid which stores only its first corner and level.
+ *
+ * The box class stores a copy of the dimensions and each of its 2^N
+ * corners. The compact box refers to dimensions which are shared with
+ * the rest of the grid, and stores the first corner and the level, which
+ * is a few words in total. The other corners are found on access, since
+ * they are an offset of at most one from the first corner in each
+ * dimension.
+ *
+ * The parent and subboxes are found from the first corner, without
+ * converting it to an offset. The offset, and the index of the box within
+ * its parent, are found with the shared dimensions on each call.
+ *
+ * The dimensions must outlive the box.
+ *
+ * The template parameters,
+ *      N - The number of dimensions of the box
+ *      T - The integral type.
+ */
+class compact_box {
+    using subdivision_type = typename dimensions<N, T>::subdivision_type;
+
+    const dimensions<N, T>* m_dimensions;  ///< The shared dimensions of the grid.
+    std::array<T, N> m_firstCorner;  ///< The first corner, in points at the level.
+    T m_level;  ///< The box level.
+    subdivision_type m_subDivType;  ///< The subdivision type.
+
+    /**
+     * \brief The subscript of the box among the boxes at its level.
+     */
+    std::array<T, N> box_subscript() const {
+        std::array<T, N> sub = m_firstCorner;
+        if ( m_subDivType == dimensions<N, T>::BOXES_SUBDIVISION ) {
+            for ( auto& ind : sub ) ind >>= 1;
+        }
+        return sub;
+    }
+
+    /**
+     * \brief The box with the specified subscript among the boxes at a level.
+     */
+    compact_box<N, T> from_subscript(std::array<T, N> sub, const T level) const {
+        if ( m_subDivType == dimensions<N, T>::BOXES_SUBDIVISION ) {
+            for ( auto& ind : sub ) ind <<= 1;
+        }
+        return compact_box<N, T>(*m_dimensions, sub, level, m_subDivType);
+    }
+
+ public:
+    static constexpr T m_nCorners = pow<2, N>();  ///< The number of corners.
+
+    compact_box(): m_dimensions(nullptr), m_firstCorner{}, m_level(0), m_subDivType() {}
+    compact_box(
+        const dimensions<N, T>& dims,
+        const std::array<T, N>& firstCorner,
+        const T level,
+        const subdivision_type subDiv
+    ): m_dimensions(&dims), m_firstCorner(firstCorner), m_level(level), m_subDivType(subDiv) {}
+    compact_box(
+        const dimensions<N, T>& dims,
+        const T level,
+        const subdivision_type subDiv,
+        const T offset = 0
+    ): compact_box(
+        dims,
+        dims.ind2sub(offset, level, subDiv, dimensions<N, T>::BOXES_MODE, dimensions<N, T>::POINTS_CONV),
+        level,
+        subDiv
+    ) {}
+
+    /**
+     * \brief The box only holds the address of the dimensions, and so it
+     * cannot be constructed from a temporary, such as the conversion of
+     * static dimensions.
+     */
+    compact_box(const dimensions<N, T>&&, const std::array<T, N>&, const T, const subdivision_type) = delete;
+    compact_box(const dimensions<N, T>&&, const T, const subdivision_type, const T = 0) = delete;
+
+    T get_level() const {return m_level;}  ///< Get the box level.
+    subdivision_type get_subdivision_type() const {return m_subDivType;}  ///< Get the subdivision type.
+    const dimensions<N, T>& get_dimensions() const {return *m_dimensions;}  ///< Get the shared dimensions.
+
+    /**
+     * \brief Get the box offset.
+     */
+    T get_offset() const {
+        return m_dimensions->sub2ind(
+            m_firstCorner,
+            m_level,
+            m_subDivType,
+            dimensions<N, T>::POINTS_MODE,
+            dimensions<N, T>::BOXES_CONV
+        );
+    }
+
+    /**
+     * \brief Get the index of the box within its parent box.
+     */
+    T index_in_parent() const {
+        if ( m_level == 0 ) {
+            return 0;
+        }
+        std::array<T, N> local = box_subscript();
+        for ( auto& ind : local ) ind %= 2;
+        return m_dimensions->sub2ind(local, m_level - 1, m_subDivType, dimensions<N, T>::LOCAL_BOXES);
+    }
+
+    /**
+     * \brief The ith corner of the box.
+     */
+    index<N, T> operator[](const T i) const {
+        const auto unit = dimensions<N, T>::unitary(i);
+        std::array<T, N> corner = m_firstCorner;
+        for ( size_t d = 0; d < N; ++d ) {
+            corner[d] += unit[d];
+        }
+        return index<N, T>(corner, m_level);
+    }
+
+    /**
+     * \brief All of the corners of the box.
+     */
+    std::array<index<N, T>, m_nCorners> corners() const {
+        std::array<index<N, T>, m_nCorners> ret;
+        for ( T i = 0; i < m_nCorners; ++i ) {
+            ret[i] = operator[](i);
+        }
+        return ret;
+    }
+
+    /**
+     * \brief The parent of the box, or the box itself at level 0.
+     */
+    compact_box<N, T> parent() const {
+        if ( m_level == 0 ) {
+            return *this;
+        }
+        std::array<T, N> sub = box_subscript();
+        for ( auto& ind : sub ) ind >>= 1;
+        return from_subscript(sub, m_level - 1);
+    }
+
+    /**
+     * \brief The subbox after binary subdivision, in the direction of
+     * the specified corner.
+     */
+    compact_box<N, T> subbox(const T ind) const {
+        const auto unit = dimensions<N, T>::unitary(ind);
+        std::array<T, N> sub = box_subscript();
+        for ( size_t d = 0; d < N; ++d ) {
+            sub[d] = 2*sub[d] + unit[d];
+        }
+        return from_subscript(sub, m_level + 1);
+    }
+
+    /**
+     * \brief The neighbour of the box within its parent, or the box with
+     * the specified offset at level 0.
+     */
+    compact_box<N, T> neighbour(const T ind) const {
+        if ( m_level == 0 ) {
+            return compact_box<N, T>(*m_dimensions, 0, m_subDivType, ind);
+        }
+        return parent().subbox(ind);
+    }
+
+    /**
+     * \brief Construct the box, with its dimensions and corners.
+     */
+    box<N, T> to_box() const {
+        return box<N, T>(*m_dimensions, m_level, m_subDivType, get_offset());
+    }
+
+    /**
+     * \brief Return true if the boxes have the same level and corners.
+     */
+    bool operator==(const compact_box<N, T>& other) const {
+        return m_level == other.m_level && m_firstCorner == other.m_firstCorner;
+    }
+};
+}  // namespace gs
+
+#endif  // LIB_BASE_COMPACT_BOX_HPP_
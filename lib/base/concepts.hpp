@@ -44,6 +44,19 @@ template<typename T>
 concept random_access_container = (
     iterable<T> && has_value<T> && random_access<T>
 );
+
+template<typename V, typename B>
+/**
+ * \brief Tree visitor concept.
+ *
+ * The visitor is called on entry to and exit from each box which has
+ * children, and once on each leaf.
+ */
+concept tree_visitor = requires(V v, const B b) {
+    v.on_enter(b);
+    v.on_leaf(b);
+    v.on_exit(b);
+};  // NOLINT(readability/braces)
 }  // namespace gs
 
 #endif  // LIB_BASE_CONCEPTS_HPP_
@@ -4,9 +4,14 @@
 
 #include <inttypes.h>
 
+#include <algorithm>
 #include <iostream>
 #include <array>
+#include <bit>
 #include <exception>
+#include <limits>
+#include <span>
+#include <stdexcept>
 
 #include "base/tools.hpp"
 #include "base/concepts.hpp"
@@ -34,6 +39,10 @@ requires std::is_integral<T>::value && (N > 0)
  * is able to index both boxes and points, using the point parameter
  * on each method. If it is true then it uses grid locations.
  * 
+ * When every base dimension is a power of two, the dimensions of the boxes
+ * subdivision are powers of two at every level, and the conversions between
+ * an index and a subscript use shifts and masks in place of division.
+ * 
  * The template parameters,
  *      N - The number of dimensions of the box
  *      T - The integral type.
@@ -47,7 +56,7 @@ class dimensions {
      * \brief Return a vector in which each element is no greater than
      * size, to indicate the direction of the numeric index.
      */
-    static std::array<T, N> unitary(T ind, T size = 1) {
+    static constexpr std::array<T, N> unitary(T ind, T size = 1) {
         ind %= pow<2, N>();
         std::array<T, N> unit;
         unit.fill(0);
@@ -59,13 +68,28 @@ class dimensions {
         return unit;
     }
 
-    dimensions(): m_dimensions{}, m_maxLevel(0) {m_dimensions.fill(0);}
-    dimensions(std::array<T, N> dimensions, T maxLevel):
+    constexpr dimensions(): m_dimensions{}, m_maxLevel(0) {m_dimensions.fill(0);}
+    constexpr dimensions(std::array<T, N> dimensions, T maxLevel):
         m_dimensions(dimensions), m_maxLevel(maxLevel) {}
-    dimensions(T dimensions, T maxLevel): m_dimensions{}, m_maxLevel(maxLevel) {
+    constexpr dimensions(T dimensions, T maxLevel): m_dimensions{}, m_maxLevel(maxLevel) {
         m_dimensions.fill(dimensions);
     }
 
+    /**
+     * \brief Whether every dimension is a power of two, and larger than one.
+     * 
+     * A dimension of one has no boxes at level 0 in the boxes subdivision,
+     * and so it is excluded. The check has no branches, so that a loop of
+     * conversions can be split on it once rather than test it on each one.
+     */
+    static constexpr bool power_of_two(const std::array<T, N>& dims) {
+        bool powers = true;
+        for ( const auto dim : dims ) {
+            powers &= (dim >= 2) & ((dim & (dim-1)) == 0);
+        }
+        return powers;
+    }
+
     /**
      * \brief The subdivision type.
      * 
@@ -113,6 +137,17 @@ class dimensions {
         LOCAL_BOXES,      // Local boxes as input / output
     };
 
+    /**
+     * \brief The order of the points and boxes in memory.
+     *
+     * The position of a point or box in the storage of its level is its
+     * row-major index, or its Z-order (Morton) index as given by sub2morton.
+     */
+    enum storage_layout {
+        ROW_MAJOR = 0,  // The order of the row-major index
+        MORTON          // Z-order inside each box at level 0
+    };
+
     /**
      * \brief How to convert the output.
      * 
@@ -137,7 +172,7 @@ class dimensions {
      * difference equation does not hold. The dimension becomes 2 at the
      * first level in this case.
      */
-    std::array<T, N> level_dims(
+    GS_ALWAYS_INLINE constexpr std::array<T, N> level_dims(
         const T level,
         const subdivision_type subDiv,
         const modality mode
@@ -214,47 +249,134 @@ class dimensions {
         return levelDims;
     }
 
+    /**
+     * \brief Whether the conversions with the specified subdivision and
+     * mode use shifts and masks.
+     * 
+     * The dimensions of the boxes subdivision, and of the local boxes, are
+     * powers of two at every level when the base dimensions are. The check
+     * is made on each call rather than stored, since the dimensions are
+     * copied by every box and index, and their size is on the critical path.
+     */
+    constexpr bool shifted(const subdivision_type subDiv, const modality mode) const {
+        return (subDiv == BOXES_SUBDIVISION || mode == LOCAL_BOXES) && power_of_two(m_dimensions);
+    }
+
     /**
      * \brief Get the maximum level.
      */
-    T max_level() const {
+    constexpr T max_level() const {
         return m_maxLevel;
     }
 
     /**
      * \brief Get the maximum index at the specified level.
+     * 
+     * Every index at the level is less than the maximum index, and so
+     * an exception is thrown if it can not be represented by the integral
+     * type. The dimensions at a level are never larger than the base
+     * dimensions shifted by the level.
      */
-    T max_ind(
+    constexpr T max_ind(
         const T level,
         const subdivision_type subDiv,
         const modality mode
     ) const {
+        for ( const auto dim : m_dimensions ) {
+            if ( level >= std::numeric_limits<T>::digits || dim > (std::numeric_limits<T>::max() >> level) ) {
+                throw std::overflow_error("The dimensions overflow the index type");
+            }
+        }
         const std::array<T, N> levelDims = dimensions<N, T>::level_dims(
             level, subDiv, mode
         );
         T total = 1;
         for ( const auto dim : levelDims ) {
-            total *= dim;
+            if ( __builtin_mul_overflow(total, dim, &total) ) {
+                throw std::overflow_error("The dimensions overflow the index type");
+            }
         }
         return total;
     }
 
+    /**
+     * \brief Convert an index into a subscript, using the dimensions of
+     * its level.
+     * 
+     * The dimensions of a level can be found once with level_dims and
+     * reused for every conversion at that level, which avoids selecting
+     * them on each call.
+     */
+    static constexpr std::array<T, N> ind2sub(T ind, const std::array<T, N>& levelDims) {
+        std::array<T, N> indices;
+        for ( T i = 1; i <= N; ++i ) {
+            indices[N-i] = ind % levelDims[N-i];
+            ind /= levelDims[N-i];
+        }
+        return indices;
+    }
+
+    /**
+     * \brief Convert a subscript into an index, using the dimensions of
+     * its level.
+     */
+    static constexpr T sub2ind(const std::array<T, N>& indices, const std::array<T, N>& levelDims) {
+        T retInd = indices[N-1];
+        T coef = levelDims[N-1];
+        for ( T i = 2; i <= N; ++i ) {
+            DEBUG_ASSERT(indices[N-i] < levelDims[N-i])
+            retInd += coef*indices[N-i];
+            coef *= levelDims[N-i];
+        }
+        return retInd;
+    }
+
+    /**
+     * \brief Convert an index into a subscript, when the dimensions of its
+     * level are powers of two.
+     */
+    static constexpr std::array<T, N> ind2sub_shifted(T ind, const std::array<T, N>& levelDims) {
+        std::array<T, N> indices;
+        for ( T i = 1; i <= N; ++i ) {
+            indices[N-i] = ind & (levelDims[N-i]-1);
+            ind >>= std::countr_zero(static_cast<std::make_unsigned_t<T>>(levelDims[N-i]));
+        }
+        return indices;
+    }
+
+    /**
+     * \brief Convert a subscript into an index, when the dimensions of its
+     * level are powers of two.
+     */
+    static constexpr T sub2ind_shifted(const std::array<T, N>& indices, const std::array<T, N>& levelDims) {
+        T retInd = indices[N-1];
+        int shift = std::countr_zero(static_cast<std::make_unsigned_t<T>>(levelDims[N-1]));
+        for ( T i = 2; i <= N; ++i ) {
+            DEBUG_ASSERT(indices[N-i] < levelDims[N-i])
+            retInd += indices[N-i] << shift;
+            shift += std::countr_zero(static_cast<std::make_unsigned_t<T>>(levelDims[N-i]));
+        }
+        return retInd;
+    }
+
     /**
      * \brief Get the grid dimensions from an index, at the specified level.
      */
-    std::array<T, N> ind2sub(
+    GS_ALWAYS_INLINE constexpr std::array<T, N> ind2sub(
         const T ind,
         const T level = 0,
         const subdivision_type subDiv = POINTS_SUBDIVISION,
         const modality mode = POINTS_MODE,
         const conversion conv = dimensions<N, T>::NO_CONV
     ) const {
-        T coef = 1;
         std::array<T, N> levelDims = dimensions<N, T>::level_dims(level, subDiv, mode);
         // Get the index at the specified level.
-        std::array<T, N> indices;
+        std::array<T, N> indices = (
+            shifted(subDiv, mode) ?
+            ind2sub_shifted(ind, levelDims) :
+            ind2sub(ind, levelDims)
+        );
         for ( T i = 1; i <= N; ++i ) {
-            indices[N-i] = (ind / coef) % levelDims[N-i];
             switch (conv) {
             case dimensions<N, T>::POINTS_CONV:
                 if (subDiv == dimensions<N, T>::BOXES_SUBDIVISION) indices[N-i]*=2;
@@ -268,7 +390,6 @@ class dimensions {
             case dimensions<N, T>::NO_CONV:
                 break;
             }
-            coef *= levelDims[N-i];
         }
         return indices;
     }
@@ -276,31 +397,29 @@ class dimensions {
     /**
      * \brief Get a one dimensional index representation, at the specified level.
      */
-    T sub2ind(
+    GS_ALWAYS_INLINE constexpr T sub2ind(
         std::array<T, N> indices,
         const T level = 0,
         const subdivision_type subDiv = POINTS_SUBDIVISION,
         const modality mode = POINTS_MODE,
         const conversion conv = dimensions<N, T>::NO_CONV
     ) const {
-        std::array<T, N> levelDims;
-
+        // The dimensions of the mode which is converted to
+        modality levelMode = mode;
         switch ( conv ) {
         case dimensions<N, T>::POINTS_CONV:
-            levelDims = dimensions<N, T>::level_dims(level, subDiv, dimensions<N, T>::POINTS_MODE);
+            levelMode = dimensions<N, T>::POINTS_MODE;
             break;
         case dimensions<N, T>::BOXES_CONV:
-            levelDims = dimensions<N, T>::level_dims(level, subDiv, dimensions<N, T>::BOXES_MODE);
+            levelMode = dimensions<N, T>::BOXES_MODE;
             break;
         case dimensions<N, T>::LOCAL_CONV:
-            levelDims = dimensions<N, T>::level_dims(level, subDiv, dimensions<N, T>::LOCAL_BOXES);
+            levelMode = dimensions<N, T>::LOCAL_BOXES;
             break;
         case dimensions<N, T>::NO_CONV:
-            levelDims = dimensions<N, T>::level_dims(level, subDiv, mode);
             break;
         }
-
-        T coef = levelDims[N-1];
+        const std::array<T, N> levelDims = dimensions<N, T>::level_dims(level, subDiv, levelMode);
 
         switch ( conv ) {
         case dimensions<N, T>::POINTS_CONV:
@@ -319,13 +438,149 @@ class dimensions {
             break;
         }
 
-        T retInd = indices[N-1];
+        if ( shifted(subDiv, (conv == dimensions<N, T>::LOCAL_CONV) ? dimensions<N, T>::LOCAL_BOXES : mode) ) {
+            return sub2ind_shifted(indices, levelDims);
+        }
+        return sub2ind(indices, levelDims);
+    }
+
+    /**
+     * \brief Convert a span of indices into subscripts, at the specified
+     * level.
+     * 
+     * The subscripts are written with one span for each dimension, which
+     * must be the size of the indices. The dimensions of the level are
+     * found once. When they are powers of two each dimension is converted
+     * over the whole span with a shift and a mask, so that the loops can be
+     * vectorised. Otherwise each index is divided in turn, since integer
+     * division is not vectorised.
+     */
+    void ind2sub(
+        std::span<const T> inds,
+        const std::array<std::span<T>, N>& subs,
+        const T level = 0,
+        const subdivision_type subDiv = POINTS_SUBDIVISION,
+        const modality mode = POINTS_MODE
+    ) const {
+        const std::array<T, N> levelDims = level_dims(level, subDiv, mode);
+        const size_t size = inds.size();
+        if ( shifted(subDiv, mode) ) {
+            int shift = 0;
+            for ( T i = 1; i <= N; ++i ) {
+                DEBUG_ASSERT(subs[N-i].size() == size)
+                const T mask = levelDims[N-i]-1;
+                T* sub = subs[N-i].data();
+                for ( size_t k = 0; k < size; ++k ) {
+                    sub[k] = (inds[k] >> shift) & mask;
+                }
+                shift += std::countr_zero(static_cast<std::make_unsigned_t<T>>(levelDims[N-i]));
+            }
+            return;
+        }
+        for ( size_t k = 0; k < size; ++k ) {
+            T ind = inds[k];
+            for ( T i = 1; i <= N; ++i ) {
+                subs[N-i][k] = ind % levelDims[N-i];
+                ind /= levelDims[N-i];
+            }
+        }
+    }
+
+    /**
+     * \brief Convert spans of subscripts into indices, at the specified
+     * level.
+     * 
+     * The subscripts are read with one span for each dimension, and the
+     * indices are written into a span of the same size.
+     */
+    void sub2ind(
+        const std::array<std::span<const T>, N>& subs,
+        std::span<T> inds,
+        const T level = 0,
+        const subdivision_type subDiv = POINTS_SUBDIVISION,
+        const modality mode = POINTS_MODE
+    ) const {
+        const std::array<T, N> levelDims = level_dims(level, subDiv, mode);
+        const size_t size = inds.size();
+        T* ind = inds.data();
+        DEBUG_ASSERT(subs[N-1].size() == size)
+        std::copy(subs[N-1].begin(), subs[N-1].end(), ind);
+        T coef = levelDims[N-1];
         for ( T i = 2; i <= N; ++i ) {
-            DEBUG_ASSERT(indices[N-i] < levelDims[N-i])
-            retInd += coef*indices[N-i];
+            DEBUG_ASSERT(subs[N-i].size() == size)
+            const T* sub = subs[N-i].data();
+            for ( size_t k = 0; k < size; ++k ) {
+                ind[k] += coef*sub[k];
+            }
             coef *= levelDims[N-i];
         }
-        return retInd;
+    }
+
+    /**
+     * \brief Get the Z-order (Morton) index of a box or point, at the
+     * specified level, using the boxes subdivision.
+     * 
+     * The boxes at level 0 are in row-major order, and the boxes or points
+     * inside each of them are in Z-order, which interleaves the bits of
+     * their position so that the first dimension is the most significant.
+     * The children of a box, and the corners of a box at the finest level,
+     * are therefore contiguous. Each dimension must be even, so that the
+     * boxes at level 0 tile the grid.
+     */
+    constexpr T sub2morton(
+        const std::array<T, N>& indices,
+        const T level,
+        const modality mode = POINTS_MODE
+    ) const {
+        // The number of bits of each index inside its box at level 0
+        const T nBits = (mode == POINTS_MODE) ? level + 1 : level;
+        T rootInd = 0;
+        for ( T i = 0; i < N; ++i ) {
+            DEBUG_ASSERT(m_dimensions[i] % 2 == 0)
+            rootInd = rootInd*(m_dimensions[i] >> 1) + (indices[i] >> nBits);
+        }
+        T code = 0;
+        for ( T b = nBits; b-- > 0; ) {
+            for ( T i = 0; i < N; ++i ) {
+                code = (code << 1) | ((indices[i] >> b) & 1);
+            }
+        }
+        return (rootInd << (N*nBits)) | code;
+    }
+
+    /**
+     * \brief Get the position of a box or point from its Z-order (Morton)
+     * index, at the specified level, using the boxes subdivision.
+     *
+     * This is the inverse of sub2morton.
+     */
+    constexpr std::array<T, N> morton2sub(
+        const T code,
+        const T level,
+        const modality mode = POINTS_MODE
+    ) const {
+        const T nBits = (mode == POINTS_MODE) ? level + 1 : level;
+        std::array<T, N> indices;
+        indices.fill(0);
+        for ( T b = 0; b < nBits; ++b ) {
+            for ( T i = 0; i < N; ++i ) {
+                indices[i] |= ((code >> (b*N + N-1-i)) & 1) << b;
+            }
+        }
+        // The boxes at level 0 use shifts and masks, as in ind2sub_shifted
+        T rootInd = code >> (N*nBits);
+        const bool rootShifted = power_of_two(m_dimensions);
+        for ( T i = 1; i <= N; ++i ) {
+            const T rootDim = m_dimensions[N-i] >> 1;
+            if ( rootShifted ) {
+                indices[N-i] |= (rootInd & (rootDim-1)) << nBits;
+                rootInd >>= std::countr_zero(static_cast<std::make_unsigned_t<T>>(rootDim));
+            } else {
+                indices[N-i] |= (rootInd % rootDim) << nBits;
+                rootInd /= rootDim;
+            }
+        }
+        return indices;
     }
 };
 }  // namespace gs
@@ -2,12 +2,17 @@
 #ifndef LIB_BASE_GRID_HPP_
 #define LIB_BASE_GRID_HPP_
 
+#include <algorithm>
+#include <memory_resource>
+#include <span>
 #include <vector>
 #include <functional>
 
 #include "base/tools.hpp"
 #include "base/dimensions.hpp"
 #include "base/box.hpp"
+#include "base/box_handle.hpp"
+#include "base/compact_box.hpp"
 #include "base/index.hpp"
 #include "base/concepts.hpp"
 #include "base/pattern.hpp"
@@ -34,6 +39,22 @@ requires std::is_integral<S>::value
  * the points using the specified pattern. For example, in the fmm algorithm
  * it is parsed from the lowest level to the top and back again.
  * 
+ * The points and boxes can be stored in Z-order (Morton order), so that the
+ * corners of each box at the finest level, and the children of each box, are
+ * contiguous in memory. An integer, an index or a box addresses the grid by
+ * its row-major index. A box handle, point_value and box_value address it by
+ * the position in storage, and so they are used on the hot paths. In the
+ * Morton layout the parent and children of a handle are then found with a
+ * shift, and the iteration over handles and duel boxes follows the storage.
+ * 
+ * The boxes of every level are held in a single allocation, level after
+ * level from the coarsest, and a table of offsets gives the start of each
+ * level. The whole tree can then be reset, swept or copied in one pass.
+ * 
+ * The storage is allocated from a memory resource, which by default is the
+ * heap. A mapped_resource places the storage in files, so that grids which
+ * are larger than the physical memory can be traversed in tiles.
+ * 
  *  * The template parameters,
  *      M           - The number of dimensions of the grid.
  *      GridElement - The object to store at each point.
@@ -43,37 +64,228 @@ requires std::is_integral<S>::value
 class grid {
     using subdivision_type = typename dimensions<N, S>::subdivision_type;
 
-    std::vector<GridElement> m_gridStorage;  ///< Storage at each of the points in the grid.
-    std::vector<std::vector<BoxElement>> m_boxStorage;  ///< Storage at each level of the 2^N tree.
+ public:
+    using storage_layout = typename dimensions<N, S>::storage_layout;  ///< The order of the points and boxes in memory.
+    static constexpr storage_layout ROW_MAJOR = dimensions<N, S>::ROW_MAJOR;  ///< The order of the row-major index.
+    static constexpr storage_layout MORTON = dimensions<N, S>::MORTON;  ///< Z-order inside each box at level 0.
+
+ private:
+    std::pmr::vector<GridElement> m_gridStorage;  ///< Storage at each of the points in the grid.
+    std::pmr::vector<BoxElement> m_boxStorage;  ///< Storage at every level of the 2^N tree, coarsest first.
+    std::vector<S> m_levelOffsets;  ///< The start of each level in the box storage, and its end.
     dimensions<N, S> m_dimensions;  ///< The dimensions of the grid.
+    std::array<S, N> m_pointDims;  ///< The dimensions of the points at the finest level.
     subdivision_type m_subDivType;  ///< The subdivision type
+    storage_layout m_layout;  ///< The storage layout.
+
+    template<class V>
+    /**
+     * \brief Visit the subtree of a box, depth first.
+     */
+    void visit_subtree(V& visitor, const compact_box<N, S>& boxVal) const {
+        if ( boxVal.get_level()+1 >= m_dimensions.max_level() ) {
+            visitor.on_leaf(boxVal);
+            return;
+        }
+        visitor.on_enter(boxVal);
+        for ( S i = 0; i < compact_box<N, S>::m_nCorners; ++i ) {
+            visit_subtree(visitor, boxVal.subbox(i));
+        }
+        visitor.on_exit(boxVal);
+    }
+
+    template<class F>
+    /**
+     * \brief Visit the duel boxes of a tile whose colour matches in the
+     * dimensions of the mask.
+     * 
+     * The colour of a duel box has the parity of its position in dimension d
+     * as bit d, and so a mask of zero visits every duel box of the tile.
+     */
+    void visit_duel_tile(const F& callable, const S tileLevel, const S tile, const S colour, const S mask) const {
+        DEBUG_ASSERT( m_subDivType == (dimensions<N, S>::BOXES_SUBDIVISION) )
+        const S leafLevel = m_dimensions.max_level()-1;
+        const S level = std::min(tileLevel, leafLevel);
+        const S shift = leafLevel - level;
+        const auto nBoxes = box_duel_iterator<N, S>::n_duel_boxes(m_dimensions, leafLevel);
+        const auto visit = [&](const std::array<S, N>& duelIndex) {
+            S parity = 0;
+            for ( S d = 0; d < N; ++d ) {
+                // The boxes at the finest level in the last row hold no duel box
+                if ( duelIndex[d] >= nBoxes[d] ) return;
+                parity |= (duelIndex[d] & 1) << d;
+            }
+            if ( (parity & mask) == (colour & mask) ) {
+                callable(box_duel_iterator<N, S>::duel_box(m_dimensions, leafLevel, duelIndex));
+            }
+        };
+        const S tileSize = S(1) << (N*shift);
+        if ( m_layout == MORTON ) {
+            for ( S i = 0; i < tileSize; ++i ) {
+                visit(m_dimensions.morton2sub((tile << (N*shift)) + i, leafLevel, dimensions<N, S>::BOXES_MODE));
+            }
+            return;
+        }
+        const auto first = m_dimensions.ind2sub(tile, level, m_subDivType, dimensions<N, S>::BOXES_MODE);
+        for ( S i = 0; i < tileSize; ++i ) {
+            // The last dimension changes fastest, as in the storage
+            std::array<S, N> duelIndex;
+            S remainder = i;
+            for ( S d = N; d-- > 0; ) {
+                duelIndex[d] = (first[d] << shift) + (remainder & ((S(1) << shift) - 1));
+                remainder >>= shift;
+            }
+            visit(duelIndex);
+        }
+    }
 
  public:
     grid() = delete;
-    grid(const dimensions<N, S> dims, const subdivision_type subDiv):
+    grid(
+        const dimensions<N, S> dims,
+        const subdivision_type subDiv,
+        const storage_layout layout = ROW_MAJOR,
+        std::pmr::memory_resource* resource = std::pmr::get_default_resource()
+    ):
         m_gridStorage(
             dims.max_ind(
                 dims.max_level()-1,
                 subDiv,
                 dimensions<N, S>::POINTS_MODE
-            )
+            ),
+            resource
         ),
-        m_boxStorage(dims.max_level()),
+        m_boxStorage(resource),
+        m_levelOffsets(dims.max_level()+1, 0),
         m_dimensions(dims),
-        m_subDivType(subDiv) {
-        S i = 0;
-        for ( auto& boxStore : m_boxStorage ) {
-            boxStore.resize(
-                dims.max_ind(i++, subDiv, dimensions<N, S>::BOXES_MODE)
+        m_pointDims(dims.level_dims(dims.max_level()-1, subDiv, dimensions<N, S>::POINTS_MODE)),
+        m_subDivType(subDiv),
+        m_layout(layout) {
+        for ( S level = 0; level < dims.max_level(); ++level ) {
+            m_levelOffsets[level+1] = m_levelOffsets[level] + dims.max_ind(
+                level,
+                subDiv,
+                dimensions<N, S>::BOXES_MODE
             );
         }
+        m_boxStorage.resize(m_levelOffsets.back());
+        if ( m_layout == MORTON ) {
+            if ( subDiv != dimensions<N, S>::BOXES_SUBDIVISION ) {
+                throw std::range_error("The Morton layout requires the boxes subdivision");
+            }
+            for ( S d = 0; d < N; ++d ) {
+                if ( dims.level_dims(0, subDiv, dimensions<N, S>::POINTS_MODE)[d] % 2 != 0 ) {
+                    throw std::range_error("The Morton layout requires even dimensions");
+                }
+            }
+        }
     }
 
     /**
-     * \brief Set the grid storage.
+     * \brief Set the grid storage from values in row-major order.
      */
     void set_grid(const std::vector<GridElement>& grid) {
-        m_gridStorage = grid;
+        if ( m_layout == ROW_MAJOR ) {
+            m_gridStorage.assign(grid.begin(), grid.end());
+            return;
+        }
+        for ( S j = 0; j < grid.size(); ++j ) {
+            m_gridStorage[point_storage_index(j)] = grid[j];
+        }
+    }
+
+    /**
+     * \brief Get the grid storage as values in row-major order.
+     */
+    std::vector<GridElement> row_major() const {
+        if ( m_layout == ROW_MAJOR ) {
+            return std::vector<GridElement>(m_gridStorage.begin(), m_gridStorage.end());
+        }
+        std::vector<GridElement> grid(m_gridStorage.size());
+        for ( S j = 0; j < grid.size(); ++j ) {
+            grid[j] = m_gridStorage[point_storage_index(j)];
+        }
+        return grid;
+    }
+
+    /**
+     * \brief Get the storage layout.
+     */
+    storage_layout get_layout() const {return m_layout;}
+
+    /**
+     * \brief The position in the storage of a point, from its row-major index.
+     */
+    S point_storage_index(const S i) const {
+        if ( m_layout == ROW_MAJOR ) {
+            return i;
+        }
+        return m_dimensions.sub2morton(dimensions<N, S>::ind2sub(i, m_pointDims), m_dimensions.max_level()-1);
+    }
+
+    /**
+     * \brief The position in the level storage of a box, from its row-major offset.
+     */
+    S box_storage_index(const S level, const S offset) const {
+        if ( m_layout == ROW_MAJOR ) {
+            return offset;
+        }
+        return m_dimensions.sub2morton(
+            m_dimensions.ind2sub(offset, level, m_subDivType, dimensions<N, S>::BOXES_MODE),
+            level,
+            dimensions<N, S>::BOXES_MODE
+        );
+    }
+
+    /**
+     * \brief The handle of a box, which holds its position in the level storage.
+     */
+    box_handle<N, S> handle(const compact_box<N, S>& boxVal) const {
+        if ( m_layout == ROW_MAJOR ) {
+            return box_handle<N, S>(boxVal.get_level(), boxVal.get_offset());
+        }
+        std::array<S, N> sub = boxVal[0];
+        for ( auto& ind : sub ) ind >>= 1;
+        return box_handle<N, S>(
+            boxVal.get_level(),
+            m_dimensions.sub2morton(sub, boxVal.get_level(), dimensions<N, S>::BOXES_MODE)
+        );
+    }
+
+    /**
+     * \brief The parent of a box handle, or the box itself at level 0.
+     * 
+     * In the Morton layout the children of a box at position p are at
+     * 2^N p + i in the level below, where i is their index in the parent,
+     * and so the parent is a shift of the position.
+     */
+    box_handle<N, S> parent(const box_handle<N, S>& handle) const {
+        if ( m_layout == ROW_MAJOR ) {
+            return handle.parent(m_dimensions, m_subDivType);
+        }
+        if ( handle.get_level() == 0 ) {
+            return handle;
+        }
+        return box_handle<N, S>(handle.get_level() - 1, handle.get_offset() >> N);
+    }
+
+    /**
+     * \brief The subbox of a box handle, in the direction of the
+     * specified corner.
+     */
+    box_handle<N, S> subbox(const box_handle<N, S>& handle, const S ind) const {
+        if ( m_layout == ROW_MAJOR ) {
+            return handle.subbox(ind, m_dimensions, m_subDivType);
+        }
+        return box_handle<N, S>(handle.get_level() + 1, (handle.get_offset() << N) | ind);
+    }
+
+    /**
+     * \brief The start of a level in the box storage, or the total
+     * number of boxes for the maximum level.
+     */
+    S level_offset(const S level) const {
+        return m_levelOffsets[level];
     }
 
     /**
@@ -88,17 +300,89 @@ class grid {
         return m_dimensions;
     }
 
+    /**
+     * \brief Get the subdivision type of the grid.
+     */
+    subdivision_type get_subdivision_type() const {
+        return m_subDivType;
+    }
+
+    /**
+     * \brief Access the box storage of every level, in storage order.
+     */
+    std::span<BoxElement> box_storage() {
+        return std::span<BoxElement>(m_boxStorage);
+    }
+
+    /**
+     * \brief Access the box storage of every level, in storage order.
+     */
+    std::span<const BoxElement> box_storage() const {
+        return std::span<const BoxElement>(m_boxStorage);
+    }
+
+    /**
+     * \brief Access the box storage of an entire level, in storage order.
+     */
+    std::span<BoxElement> level_storage(const S level) {
+        return box_storage().subspan(m_levelOffsets[level], m_levelOffsets[level+1] - m_levelOffsets[level]);
+    }
+
+    /**
+     * \brief Access the box storage of an entire level, in storage order.
+     */
+    std::span<const BoxElement> level_storage(const S level) const {
+        return box_storage().subspan(m_levelOffsets[level], m_levelOffsets[level+1] - m_levelOffsets[level]);
+    }
+
+    /**
+     * \brief Access the box storage using the level of a box and its
+     * position in the level storage.
+     */
+    BoxElement& box_value(const S level, const S position) {
+        return m_boxStorage[m_levelOffsets[level] + position];
+    }
+
+    /**
+     * \brief Access the box storage using the level of a box and its
+     * position in the level storage.
+     */
+    const BoxElement& box_value(const S level, const S position) const {
+        return m_boxStorage[m_levelOffsets[level] + position];
+    }
+
+    /**
+     * \brief Access the grid storage using the position of a point in storage.
+     */
+    GridElement& point_value(const S position) {
+        return m_gridStorage[position];
+    }
+
+    /**
+     * \brief Access the grid storage using the position of a point in storage.
+     */
+    const GridElement& point_value(const S position) const {
+        return m_gridStorage[position];
+    }
+
+    /**
+     * \brief Reset every box to its default value, in place.
+     */
+    void clear_boxes() {
+        std::fill(m_boxStorage.begin(), m_boxStorage.end(), BoxElement());
+    }
+
     /**
      * \brief Access the grid storage using an integer.
      */
     GridElement& operator[](const S i) {
-        return m_gridStorage[i];
+        return m_gridStorage[point_storage_index(i)];
     }
     /**
      * \brief Access the grid storage using an integer.
      */
     const GridElement& operator[](const S i) const {
-        return m_gridStorage[i];
+        return m_gridStorage[point_storage_index(i)];
     }
 
     /**
@@ -106,11 +390,9 @@ class grid {
      */
     GridElement& operator[](const index<N, S>& ind) {
         return operator[](
-            m_dimensions.sub2ind(
+            dimensions<N, S>::sub2ind(
                 ind.at_level(m_dimensions.max_level()-1, m_subDivType),
-                m_dimensions.max_level()-1,
-                m_subDivType,
-                dimensions<N, S>::POINTS_MODE
+                m_pointDims
             )
         );
     }
@@ -120,11 +402,9 @@ class grid {
      */
     const GridElement& operator[] (const index<N, S>& ind) const {
         return operator[](
-            m_dimensions.sub2ind(
+            dimensions<N, S>::sub2ind(
                 ind.at_level(m_dimensions.max_level()-1, m_subDivType),
-                m_dimensions.max_level()-1,
-                m_subDivType,
-                dimensions<N, S>::POINTS_MODE
+                m_pointDims
             )
         );
     }
@@ -133,14 +413,42 @@ class grid {
      * \brief Access the box storage using a box
      */
     const BoxElement& operator[] (const box<N, S>& boxVal) const {
-        return m_boxStorage[boxVal.get_level()][boxVal.get_offset()];
+        return box_value(boxVal.get_level(), box_storage_index(boxVal.get_level(), boxVal.get_offset()));
     }
 
     /**
      * \brief Access the box storage using a box
      */
     BoxElement& operator[] (const box<N, S>& boxVal) {
-        return m_boxStorage[boxVal.get_level()][boxVal.get_offset()];
+        return box_value(boxVal.get_level(), box_storage_index(boxVal.get_level(), boxVal.get_offset()));
+    }
+
+    /**
+     * \brief Access the box storage using a compact box
+     */
+    const BoxElement& operator[] (const compact_box<N, S>& boxVal) const {
+        return operator[](handle(boxVal));
+    }
+
+    /**
+     * \brief Access the box storage using a compact box
+     */
+    BoxElement& operator[] (const compact_box<N, S>& boxVal) {
+        return operator[](handle(boxVal));
+    }
+
+    /**
+     * \brief Access the box storage using a box handle
+     */
+    const BoxElement& operator[] (const box_handle<N, S>& handle) const {
+        return box_value(handle.get_level(), handle.get_offset());
+    }
+
+    /**
+     * \brief Access the box storage using a box handle
+     */
+    BoxElement& operator[] (const box_handle<N, S>& handle) {
+        return box_value(handle.get_level(), handle.get_offset());
     }
 
     /**
@@ -156,7 +464,7 @@ class grid {
         return gridValues;
     }
 
-    auto begin() -> decltype(m_gridStorage.begin()) {return m_gridStorage.begin();}  ///< Return a begin iterator into the vertices
+    auto begin() -> decltype(m_gridStorage.begin()) {return m_gridStorage.begin();}  ///< Return a begin iterator into the vertices, in storage order
     auto end() -> decltype(m_gridStorage.end()) {return m_gridStorage.end();}  ///< Return the end iterator into the vertices
     auto begin() const -> decltype(m_gridStorage.begin()) {return m_gridStorage.begin();}  ///< Return a begin iterator into the vertices
     auto end() const -> decltype(m_gridStorage.end()) {return m_gridStorage.end();}  ///< Return the end iterator into the vertices
@@ -177,7 +485,45 @@ class grid {
         );
         for ( S i = 0; i < max_ind; ++i ) {
             box<N, S> box(m_dimensions, level, m_subDivType, i);
-            callable(box, m_boxStorage[level][i]);
+            callable(box, box_value(level, box_storage_index(level, i)));
+        }
+    }
+
+    template<class F>
+    requires std::invocable<F&, const box<N, S>&>
+    /**
+     * \brief Iterate over a range of the boxes at the specified level.
+     * 
+     * The boxes are visited in the order of their offsets, and the range
+     * [first, last) is visited.
+     */
+    void iterate(
+        const F& callable,
+        const S level,
+        const S first,
+        const S last
+    ) const {
+        for ( S i = first; i < last; ++i ) {
+            callable(box<N, S>(m_dimensions, level, m_subDivType, i));
+        }
+    }
+
+    template<class F>
+    requires std::invocable<F&, const box_handle<N, S>&>
+    /**
+     * \brief Iterate over a range of the box handles at the specified level.
+     * 
+     * The boxes are visited in storage order, and the range [first, last)
+     * of positions is visited. No box is constructed.
+     */
+    void iterate(
+        const F& callable,
+        const S level,
+        const S first,
+        const S last
+    ) const {
+        for ( S i = first; i < last; ++i ) {
+            callable(box_handle<N, S>(level, i));
         }
     }
 
@@ -245,6 +591,56 @@ class grid {
         }
     }
 
+    template<class F>
+    requires std::invocable<F&, const box_stack<N, S>&>
+    /**
+     * \brief Iterate over every box at the lowest level within a range
+     * of subtrees, providing the full stack of boxes at every iteration.
+     *
+     * The subtrees are rooted at the specified level, and the range
+     * [first, last) is in the order of the box_stack_iterator. Disjoint
+     * ranges visit disjoint boxes at the specified level and below.
+     */
+    void iterate_subtrees(
+        const F& callable,
+        const S level,
+        const S first,
+        const S last
+    ) {
+        const auto lastIt = box_stack_iterator<N, S>(
+            m_dimensions,
+            m_subDivType,
+            last,
+            level
+        );
+        for (
+            auto boxIt = box_stack_iterator<N, S>(m_dimensions, m_subDivType, first, level);
+            boxIt < lastIt;
+            ++boxIt
+        ) {
+            callable(*boxIt);
+        }
+    }
+
+    template<class V>
+    requires tree_visitor<V, compact_box<N, S>>
+    /**
+     * \brief Visit every box in the tree once, depth first.
+     * 
+     * Each box with children is passed to on_enter before its subtree,
+     * and to on_exit after it, and each box at the lowest level is passed
+     * to on_leaf. The boxes at level 0 are visited in the order of their
+     * offsets, and the children of a box in the order of their index in
+     * the parent, so the leaves are in the order of the box_stack_iterator.
+     * Unlike the stacks, every ancestor is visited once rather than once
+     * for each of its leaves.
+     */
+    void visit(V& visitor) const {
+        const S nRoots = m_dimensions.max_ind(0, m_subDivType, dimensions<N, S>::BOXES_MODE);
+        for ( S i = 0; i < nRoots; ++i ) {
+            visit_subtree(visitor, compact_box<N, S>(m_dimensions, 0, m_subDivType, i));
+        }
+    }
 
     template<class F>
     requires std::invocable<F&, const base_box<N, S>&>
@@ -270,6 +666,120 @@ class grid {
             callable(*boxIt);
         }
     }
+
+    /**
+     * \brief The number of tiles of duel boxes at the tile level, which is
+     * the number of boxes at that level.
+     */
+    S n_duel_tiles(const S tileLevel) const {
+        const S level = std::min<S>(tileLevel, m_dimensions.max_level()-1);
+        return m_levelOffsets[level+1] - m_levelOffsets[level];
+    }
+
+    template<class F>
+    requires std::invocable<F&, const base_box<N, S>&>
+    /**
+     * \brief Iterate over every duel box at the lowest level, one tile
+     * at a time.
+     * 
+     * A tile is the duel boxes which start inside one box at the tile level.
+     * The tiles are visited in the storage order of their boxes, and the duel
+     * boxes within a tile in the storage order of the box at the finest level
+     * which holds their first corner. A tile only touches the points of its
+     * box and a halo of one point, and so the working set is bounded by the
+     * size of a tile rather than by the width of the grid. In the Morton
+     * layout every box is a contiguous range of the storage, and so the duel
+     * boxes are tiled at every level at once.
+     */
+    void iterate_duel_tiles(const F& callable, const S tileLevel = 0) const {
+        for ( S tile = 0; tile < n_duel_tiles(tileLevel); ++tile ) {
+            visit_duel_tile(callable, tileLevel, tile, 0, 0);
+        }
+    }
+
+    /**
+     * \brief The number of duel boxes of the specified colour at the
+     * lowest level.
+     * 
+     * The duel boxes are coloured by the parity of their position, so that
+     * bit d of the colour is the parity in dimension d. There are 2^N colours.
+     */
+    S n_duel_boxes(const S colour) const {
+        const auto nBoxes = box_duel_iterator<N, S>::n_duel_boxes(
+            m_dimensions,
+            m_dimensions.max_level()-1
+        );
+        S total = 1;
+        for ( S d = 0; d < N; ++d ) {
+            const S parity = (colour >> d) & 1;
+            total *= (nBoxes[d] + 1 - parity) / 2;
+        }
+        return total;
+    }
+
+    template<class F>
+    requires std::invocable<F&, const base_box<N, S>&>
+    /**
+     * \brief Iterate over a range of the duel boxes of one colour at the
+     * lowest level.
+     * 
+     * No two duel boxes of the same colour share a corner, or are adjacent,
+     * and so they can be visited concurrently. The boxes of each colour are
+     * numbered in the order of the box_duel_iterator, and the range
+     * [first, last) is visited.
+     */
+    void iterate_duel_colour(
+        const F& callable,
+        const S colour,
+        const S first,
+        const S last
+    ) const {
+        DEBUG_ASSERT( m_subDivType == (dimensions<N, S>::BOXES_SUBDIVISION) )
+        const auto nBoxes = box_duel_iterator<N, S>::n_duel_boxes(
+            m_dimensions,
+            m_dimensions.max_level()-1
+        );
+        std::array<S, N> nColourBoxes;
+        for ( S d = 0; d < N; ++d ) {
+            nColourBoxes[d] = (nBoxes[d] + 1 - ((colour >> d) & 1)) / 2;
+        }
+        for ( S i = first; i < last; ++i ) {
+            // The first dimension changes fastest, as in the iterator
+            std::array<S, N> duelIndex;
+            S remainder = i;
+            for ( S d = 0; d < N; ++d ) {
+                duelIndex[d] = 2*(remainder % nColourBoxes[d]) + ((colour >> d) & 1);
+                remainder /= nColourBoxes[d];
+            }
+            callable(box_duel_iterator<N, S>::duel_box(
+                m_dimensions,
+                m_dimensions.max_level()-1,
+                duelIndex
+            ));
+        }
+    }
+
+    template<class F>
+    requires std::invocable<F&, const base_box<N, S>&>
+    /**
+     * \brief Iterate over the duel boxes of one colour in a range of the
+     * tiles at the tile level.
+     * 
+     * The tiles are numbered as in iterate_duel_tiles, and the range
+     * [first, last) is visited. Disjoint ranges of the same colour can be
+     * visited concurrently, each with the working set of a tile.
+     */
+    void iterate_duel_colour_tiles(
+        const F& callable,
+        const S colour,
+        const S tileLevel,
+        const S first,
+        const S last
+    ) const {
+        for ( S tile = first; tile < last; ++tile ) {
+            visit_duel_tile(callable, tileLevel, tile, colour, pow<2, N>()-1);
+        }
+    }
 };
 }  // namespace gs
 
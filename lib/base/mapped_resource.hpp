@@ -0,0 +1,77 @@
+// Copyright 2024 Daniel Beale CC BY-NC-SA 4.0
+#ifndef LIB_BASE_MAPPED_RESOURCE_HPP_
+#define LIB_BASE_MAPPED_RESOURCE_HPP_
+
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <memory_resource>
+#include <new>
+#include <string>
+#include <vector>
+
+namespace gs {
+/**
+ * \brief A memory resource which maps every allocation onto a file.
+ *
+ * Each allocation is a new file in the specified directory, which is
+ * unlinked as soon as it is created and mapped into memory with mmap. The
+ * pages are written back to the file by the kernel rather than to swap, and
+ * so the storage of a grid can be larger than the physical memory, provided
+ * that it is traversed with a bounded working set. The files are removed
+ * by the kernel when the allocations are released, or the process exits.
+ *
+ * The resource must outlive every container which uses it. Allocations
+ * are page aligned, and so any alignment up to the page size is honoured.
+ */
+class mapped_resource : public std::pmr::memory_resource {
+    std::string m_directory;  ///< The directory of the files.
+
+    void* do_allocate(const size_t bytes, const size_t alignment) override {
+        if ( alignment > static_cast<size_t>(sysconf(_SC_PAGESIZE)) ) {
+            throw std::bad_alloc();
+        }
+        std::string path = m_directory + "/gs_mapped_XXXXXX";
+        std::vector<char> name(path.begin(), path.end());
+        name.push_back('\0');
+        const int file = mkstemp(name.data());
+        if ( file < 0 ) {
+            throw std::bad_alloc();
+        }
+        unlink(name.data());
+        const size_t length = std::max<size_t>(bytes, 1);
+        void* data = MAP_FAILED;
+        if ( ftruncate(file, length) == 0 ) {
+            data = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_NORESERVE, file, 0);
+        }
+        close(file);
+        if ( data == MAP_FAILED ) {
+            throw std::bad_alloc();
+        }
+        return data;
+    }
+
+    void do_deallocate(void* data, const size_t bytes, const size_t) override {
+        munmap(data, std::max<size_t>(bytes, 1));
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+
+ public:
+    /**
+     * \brief Map the allocations onto files in the specified directory.
+     */
+    explicit mapped_resource(const std::string& directory): m_directory(directory) {}
+
+    /**
+     * \brief Get the directory of the files.
+     */
+    const std::string& get_directory() const {return m_directory;}
+};
+}  // namespace gs
+
+#endif  // LIB_BASE_MAPPED_RESOURCE_HPP_
@@ -14,6 +14,9 @@
 #define DEBUG_ASSERT(value)
 #endif
 
+// Inline a small function at every call, whatever the size of the translation unit
+#define GS_ALWAYS_INLINE [[gnu::always_inline]]
+
 namespace gs {
 /**
  * \brief Print a message if the predicate is false.
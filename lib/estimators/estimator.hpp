@@ -2,6 +2,8 @@
 #ifndef LIB_ESTIMATORS_ESTIMATOR_HPP_
 #define LIB_ESTIMATORS_ESTIMATOR_HPP_
 
+#include <array>
+#include <span>
 #include <utility>
 #include <tuple>
 #include <vector>
@@ -40,6 +42,42 @@ concept estimator = requires(FuncEstimator<T, N, D> t) {
             gs::vector<T, N>(),
             std::array<T, 1>())
     } -> std::constructible_from<polynomial<T, N, D>>;  // There is a compute coeffs method
+    {
+        t.estimate(
+            std::array<polynomial<T, N, D>, 1>(),
+            gs::vector<T, N>(),
+            gs::vector<T, N>())
+    } -> std::same_as<gs::vector<T, 1>>;  // There is an estimate method for several polynomials
+    {
+        t.compute_coefs(
+            std::array<gs::vector<T, N>, 1>(),
+            gs::vector<T, N>(),
+            std::array<gs::vector<T, 1>, 1>())
+    } -> std::constructible_from<std::array<polynomial<T, N, D>, 1>>;  // And a compute coeffs method
+    {
+        t.compute_coefs(
+            std::span<const gs::vector<T, N>>(),
+            gs::vector<T, N>(),
+            std::span<const gs::vector<T, 1>>())
+    } -> std::constructible_from<std::array<polynomial<T, N, D>, 1>>;  // And one for any number of vectors
+    {
+        t.translate(
+            polynomial<T, N, D>(),
+            gs::vector<T, N>(),
+            gs::vector<T, N>())
+    } -> std::constructible_from<polynomial<T, N, D>>;  // There is a translate method
+    {
+        t.translate(
+            std::array<polynomial<T, N, D>, 1>(),
+            gs::vector<T, N>(),
+            gs::vector<T, N>())
+    } -> std::constructible_from<std::array<polynomial<T, N, D>, 1>>;  // And a translate method for several polynomials
+    {
+        t.bound(
+            gs::vector<T, N>(),
+            gs::vector<T, N>(),
+            T())
+    } -> std::same_as<T>;  // There is an upper bound of the function between two regions
 };  // NOLINT(readability/braces)
 }  // namespace gs
 
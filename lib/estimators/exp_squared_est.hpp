@@ -2,7 +2,10 @@
 #ifndef LIB_ESTIMATORS_EXP_SQUARED_EST_HPP_
 #define LIB_ESTIMATORS_EXP_SQUARED_EST_HPP_
 
+#include <algorithm>
+#include <array>
 #include <cmath>
+#include <span>
 
 #include "functions/exp_squared.hpp"
 #include "functions/exp_inner.hpp"
@@ -57,6 +60,21 @@ class exp_squared_est  {
         return m_taylor.estimate(poly, gs::vector<T, M>(), y-center);
     }
 
+    template<size_t L>
+    /**
+     * \brief Estimate several polynomials with the same center at once.
+     * 
+     * The result is the same as estimating each of the polynomials in turn,
+     * but the Taylor derivatives are only computed once.
+     */
+    gs::vector<T, L> estimate(
+        const std::array<polynomial<T, M, D>, L>& polys,
+        const gs::vector<T, M>& center,
+        const gs::vector<T, M>& y
+    ) const {
+        return m_taylor.estimate(polys, gs::vector<T, M>(), y-center);
+    }
+
     template<size_t K>
     /**
      * \brief Compute the polynomial coefficients for estimation
@@ -80,6 +98,138 @@ class exp_squared_est  {
         poly.fill(vectorVals, tVals);
         return poly;
     }
+
+    template<size_t K, size_t L>
+    /**
+     * \brief Compute the polynomial coefficients for several sets of
+     * values at once.
+     * 
+     * Each of the L polynomials is the same as compute_coefs with the
+     * respective element of the values, but the function is only
+     * evaluated once for each vector.
+     */
+    std::array<polynomial<T, M, D>, L> compute_coefs(
+        std::array<gs::vector<T, M>, K> vectorVals,
+        const gs::vector<T, M>& center,
+        const std::array<gs::vector<T, L>, K>& tVals
+    ) const {
+        std::array<std::array<T, K>, L> laneVals;
+        for ( size_t i = 0; i < K; ++i ) {
+            const T weight = operator()(vectorVals[i], center);
+            for ( size_t l = 0; l < L; ++l ) {
+                laneVals[l][i] = tVals[i](l)*weight;
+            }
+            vectorVals[i] -= center;
+        }
+        std::array<polynomial<T, M, D>, L> polys;
+        for ( size_t l = 0; l < L; ++l ) {
+            polys[l].fill(vectorVals, laneVals[l]);
+        }
+        return polys;
+    }
+
+    template<size_t L>
+    /**
+     * \brief Compute the polynomial coefficients for several sets of
+     * values, at a number of vectors which is only known at run time.
+     * 
+     * The result is the same as compute_coefs with the vectors in an array,
+     * and the coefficients of every vector are accumulated into a single
+     * polynomial for each lane.
+     */
+    std::array<polynomial<T, M, D>, L> compute_coefs(
+        const std::span<const gs::vector<T, M>> vectorVals,
+        const gs::vector<T, M>& center,
+        const std::span<const gs::vector<T, L>> tVals
+    ) const {
+        std::array<polynomial<T, M, D>, L> polys;
+        for ( size_t i = 0; i < vectorVals.size(); ++i ) {
+            const T weight = operator()(vectorVals[i], center);
+            const std::array<gs::vector<T, M>, 1> relative{vectorVals[i] - center};
+            for ( size_t l = 0; l < L; ++l ) {
+                polys[l].fill(relative, std::array<T, 1>{tVals[i](l)*weight});
+            }
+        }
+        return polys;
+    }
+
+    /**
+     * \brief Translate polynomial coefficients to a new center.
+     * 
+     * The coefficients computed by compute_coefs about one center are
+     * converted into those about another, without revisiting the vectors.
+     * Each weight is the exp_squared function of its vector and the center,
+     * and moving the center by d multiplies it by,
+     *   exp(x^T d / sigma^2) * exp_squared(center, newCenter),
+     * for x relative to the old center. The first factor is expanded as a
+     * series, and so the translation is accurate when the vectors are close
+     * to both centers in comparison with sigma. The coefficients are symmetric
+     * in the vectors and the point of evaluation, and so a local expansion
+     * is translated in the same way.
+     */
+    polynomial<T, M, D> translate(
+        const polynomial<T, M, D>& poly,
+        const gs::vector<T, M>& center,
+        const gs::vector<T, M>& newCenter
+    ) const {
+        const T scale = operator()(center, newCenter);
+        if ( scale == 0 ) {
+            // The centers are too far apart to interact
+            return polynomial<T, M, D>();
+        }
+        const auto shift = newCenter - center;
+        auto translated = recentre(
+            exp_reweight(poly, m_exp_inner.d_coef(center, shift)),
+            shift
+        );
+        translated *= scale;
+        return translated;
+    }
+
+    template<size_t L>
+    /**
+     * \brief Translate several polynomials with the same centers at once.
+     * 
+     * The result is the same as translating each of the polynomials in turn,
+     * but the scale and the coefficient of the re-weighting are only computed
+     * once.
+     */
+    std::array<polynomial<T, M, D>, L> translate(
+        const std::array<polynomial<T, M, D>, L>& polys,
+        const gs::vector<T, M>& center,
+        const gs::vector<T, M>& newCenter
+    ) const {
+        std::array<polynomial<T, M, D>, L> translated;
+        const T scale = operator()(center, newCenter);
+        if ( scale == 0 ) {
+            // The centers are too far apart to interact
+            return translated;
+        }
+        const auto shift = newCenter - center;
+        const auto coef = m_exp_inner.d_coef(center, shift);
+        for ( size_t l = 0; l < L; ++l ) {
+            translated[l] = recentre(exp_reweight(polys[l], coef), shift);
+            translated[l] *= scale;
+        }
+        return translated;
+    }
+
+    /**
+     * \brief An upper bound of the function between any pair of
+     * vectors within the radius of a and b respectively.
+     * 
+     * The function decreases with the distance between the vectors,
+     * and so the bound is the function at the closest possible distance.
+     */
+    T bound(
+        const gs::vector<T, M>& a,
+        const gs::vector<T, M>& b,
+        const T radius
+    ) const {
+        gs::vector<T, M> closest;
+        closest(0) = std::max((b - a).norm() - 2*radius, T(0));
+        return operator()(gs::vector<T, M>(), closest);
+    }
 };
 }  // namespace gs
 
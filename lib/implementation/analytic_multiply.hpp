@@ -2,41 +2,95 @@
 #ifndef LIB_IMPLEMENTATION_ANALYTIC_MULTIPLY_HPP_
 #define LIB_IMPLEMENTATION_ANALYTIC_MULTIPLY_HPP_
 
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <memory_resource>
+#include <span>
 #include <utility>
 #include <tuple>
 #include <vector>
 
 #include "algorithm/fmm.hpp"
+#include "algorithm/fmm_plan.hpp"
 #include "estimators/estimator.hpp"
 #include "functions/exp_squared.hpp"
 
 namespace gs {
-template<typename T, size_t M, size_t D, template < typename, size_t, size_t > class FuncEstimator>
+template<
+    typename T, size_t M, size_t D,
+    template < typename, size_t, size_t > class FuncEstimator,
+    size_t K = 1,
+    typename A = T,
+    typename S = uint32_t
+>
 requires(
-    (M > 0) && (D > 0) && estimator<T, M, D, FuncEstimator> &&
-    std::is_floating_point<T>::value
+    (M > 0) && (D > 0) && (K > 0) && estimator<T, M, D, FuncEstimator> &&
+    std::is_floating_point<T>::value && std::is_floating_point<A>::value &&
+    std::is_integral<S>::value && std::is_unsigned<S>::value
 )
 /**
  * \brief An approximation of matrix multiplication, when the
  * matrix is generated by an analytic function.
+ * 
+ * The matrix is multiplied by K vectors at once. Each point and box
+ * stores a value for each of the vectors (a lane), and the traversal
+ * of the tree, the function evaluations and the Taylor derivatives are
+ * shared between all of the lanes.
+ * 
+ * The template parameters,
+ *      T             - The base type (e.g. double or float).
+ *      M             - The number of dimensions of the grid.
+ *      D             - The degree of the polynomial estimates.
+ *      FuncEstimator - The analytic function estimator.
+ *      K             - The number of vectors to multiply.
+ *      A             - The type in which the outputs are accumulated.
+ *      S             - The integral type of the indices of the points and boxes.
+ * 
+ * The inputs, the positions, the polynomials and the function evaluations
+ * all use the base type. With a float base type and a double accumulation
+ * type the storage and the kernels are single precision, but the sum of
+ * the contributions to each point is kept in double precision, which
+ * bounds the error of the sum over many boxes and points. Only that sum is
+ * widened: the outputs are rounded back to the base type, and the errors of
+ * the single precision kernels and polynomials remain.
+ * 
+ * The geometry of the grid is held by an immutable fmm_plan, which can be
+ * shared between multiplications. The grid and box values are the state of
+ * a single run, and are reset in place by each call to compute, so the
+ * same object can be used for any number of multiplications.
+ * 
+ * Each box also stores the sum of the magnitudes of the input values that
+ * it contains. Boxes with no input are skipped in the upward pass and in the
+ * near field, and are never translated. With a positive tolerance a box of
+ * the interaction list is also skipped when the bound of its contribution
+ * to every point of the target box is below the tolerance.
+ * 
+ * The tolerance prunes single interactions, not subtrees. A box which is
+ * negligible for one target may be needed by another, and by the polynomial
+ * of its parent, and so its subtree is still aggregated. Every box of the
+ * downward pass is still visited, since each has its own interaction list.
+ * The saving is the translation of each skipped pair, which n_skipped
+ * counts, and the work of the empty boxes.
  */
 class analytic_multiply  {
  public:
      /**
      * \brief A value set at each point in the grid.
      * 
-     * The grid value contains the x and y input values, and 
-     * the output value. 
+     * The grid value contains the y input values, and the output
+     * value. The x values are held by the plan.
      */
     struct grid_val {
-        T m_targetValue;  ///< The y value that will be computed (output)
-        T m_inputValue;  ///< The y input value.
-        gs::vector<T, M> m_xVal;   ///< The input x value.
+        gs::vector<A, K> m_targetValue;  ///< The y values that will be computed (output)
+        gs::vector<T, K> m_inputValue;  ///< The y input values.
 
      public:
-        grid_val() : m_targetValue(0), m_inputValue(0) {}
-        grid_val(const T targetVal, const T inputVal, const gs::vector<T, M>& xVal) :
-            m_targetValue(targetVal), m_inputValue(inputVal), m_xVal(xVal) {}
+        grid_val() {}
+        grid_val(
+            const gs::vector<A, K>& targetVal,
+            const gs::vector<T, K>& inputVal
+        ) : m_targetValue(targetVal), m_inputValue(inputVal) {}
     };
 
     /**
@@ -46,201 +100,357 @@ class analytic_multiply  {
      * compute the result.
      */
     struct box_val {
-        polynomial<T, M, D> m_polyEstimator;  ///< The polynomial for approximating multiplication.
-        gs::vector<T, M> m_center;  ///< The center of the box.
-        bool m_centerComputed;   ///< True if the center has been computed
-        size_t m_boxUsedIndex;   ///< The index that the box has been computed at.
+        std::array<polynomial<T, M, D>, K> m_polyEstimator;  ///< The polynomials for approximating multiplication.
+        std::array<polynomial<T, M, D>, K> m_localEstimator;  ///< The local expansions of the far field.
+        T m_weight;  ///< The sum of the magnitudes of the inputs in the box.
+        S m_nSkipped;  ///< The number of boxes of the interaction list skipped by the tolerance.
+        bool m_hasLocal;  ///< True if the local expansions are not zero.
 
      public:
-        box_val() : m_centerComputed(0), m_boxUsedIndex(0) {}
+        box_val() : m_weight(0), m_nSkipped(0), m_hasLocal(false) {}
     };
 
-    using f_box_weight = std::function< void(const box_stack<M>&, grid<M, grid_val, box_val>&)>;  ///< The box weight functor
-    using f_traversal = std::function< void(const base_box<M>&, grid<M, grid_val, box_val>&)>;  ///< The traversal functor
+    using f_box_weight = std::function< void(
+        const box_stack<M, S>&,
+        grid<M, grid_val, box_val, S>&
+    )>;  ///< The box weight functor
+    using f_box_aggregate = std::function< void(const box_handle<M, S>&, grid<M, grid_val, box_val, S>&)>;  ///< The box aggregation functor
+    using f_box_local = std::function< void(const box_handle<M, S>&, grid<M, grid_val, box_val, S>&)>;  ///< The box local expansion functor
+    using f_traversal = std::function< void(const base_box<M, S>&, grid<M, grid_val, box_val, S>&)>;  ///< The traversal functor
+    using storage_layout = typename grid<M, grid_val, box_val, S>::storage_layout;  ///< The storage layout of the grid
 
  private:
     static constexpr size_t m_nBoxCorners = pow<2, M>();  ///< The number of corners of each box.
 
     using box_corners = typename std::array< gs::vector<T, M>, m_nBoxCorners>;  ///< The corners of the box
-    using box_values = typename std::array<T, m_nBoxCorners>;  ///< The values at each corner
+    using box_values = typename std::array<gs::vector<T, K>, m_nBoxCorners>;  ///< The values at each corner
 
     /**
      * \brief Get the values and points at the corners of 
-     * the input box.
+     * a box at the finest level.
      */
-    static std::pair<box_corners, box_values> corner_vals(
-        const gs::box<M>& boxImp,
-        const gs::grid<M, grid_val, box_val>& grid
-    ) {
+    std::pair<box_corners, box_values> leaf_corner_vals(
+        const S offset,
+        const gs::grid<M, grid_val, box_val, S>& grid
+    ) const {
         std::pair<box_corners, box_values> ret;
+        const auto corners = m_plan->get_interactions().leaf_corners(offset);
+        ret.first = m_plan->corner_positions(offset);
         for ( size_t i = 0; i < analytic_multiply::m_nBoxCorners; ++i ) {
-            ret.first[i] = grid[boxImp[i]].m_xVal;
-            ret.second[i] = grid[boxImp[i]].m_inputValue;
+            ret.second[i] = grid.point_value(corners[i]).m_inputValue;
         }
         return ret;
     }
 
-    dimensions<M> m_dimensions;  ///< The dimensions.
+    dimensions<M, S> m_dimensions;  ///< The dimensions.
     FuncEstimator<T, M, D> m_f_estimator;  ///< The analytic function estimator.
-    fmm<M, uint32_t, f_traversal, f_box_weight, grid_val,  box_val> m_fmm;  ///< The FMM method.
+    std::shared_ptr<const fmm_plan<M, T, S>> m_plan;  ///< The geometry of the grid.
+    T m_tolerance;  ///< The largest contribution of a box which may be skipped.
+    fmm<M, S, f_traversal, f_box_weight, f_box_aggregate, f_box_local, grid_val,  box_val> m_fmm;  ///< The FMM method.
 
  public:
-    analytic_multiply(const dimensions<M> dims, FuncEstimator<T, M, D> f_estimator):
-        m_dimensions(dims),
+    /**
+     * \brief Construct the plan of the dimensions and the multiplication.
+     * 
+     * The tables of the plan are allocated from the same memory resource as
+     * the grid, which must outlive the multiplication.
+     */
+    analytic_multiply(
+        const dimensions<M, S> dims,
+        FuncEstimator<T, M, D> f_estimator,
+        const T tolerance = 0,
+        const storage_layout layout = grid<M, grid_val, box_val, S>::ROW_MAJOR,
+        std::pmr::memory_resource* resource = std::pmr::get_default_resource()
+    ):
+        analytic_multiply(std::make_shared<const fmm_plan<M, T, S>>(dims, layout, resource), f_estimator, tolerance, resource) {}
+
+    /**
+     * \brief Construct using a precomputed plan.
+     * 
+     * The plan only depends on the dimensions and the storage layout, and
+     * so it can be shared by every multiplication on the same grid. Boxes
+     * whose contribution to each point is bounded by the tolerance are
+     * skipped. The grid and boxes are stored with the layout of the plan,
+     * and the inputs and outputs are always in row-major order. The storage
+     * is allocated from the memory resource, which must outlive the
+     * multiplication.
+     */
+    analytic_multiply(
+        std::shared_ptr<const fmm_plan<M, T, S>> plan,
+        FuncEstimator<T, M, D> f_estimator,
+        const T tolerance = 0,
+        std::pmr::memory_resource* resource = std::pmr::get_default_resource()
+    ):
+        m_dimensions(plan->get_dimensions()),
         m_f_estimator(f_estimator),
+        m_plan(plan),
+        m_tolerance(tolerance),
         m_fmm(
-            dims,
+            m_dimensions,
             [&](
-                const base_box<M>& baseBox,
-                grid<M, grid_val, box_val>& grid
+                const base_box<M, S>& baseBox,
+                grid<M, grid_val, box_val, S>& grid
             ) {
-                std::array<box<M>, base_box<M>::m_nCorners> principalBoxes;
-                // Add the boxes on the corners of the duel box.
-                for ( size_t i = 0; i < base_box<M>::m_nCorners; ++i) {
-                    principalBoxes[i] = box<M>(
-                        m_dimensions,
-                        baseBox[i],
-                        dimensions<M>::BOXES_SUBDIVISION
-                    );
-                }
+                const auto& plan = *m_plan;
+                const auto& interactions = plan.get_interactions();
+                const S duel = interactions.duel_number(baseBox);
+                const auto targets = interactions.targets(duel);
+                const auto leaves = interactions.leaves(duel);
+                const S leafLevel = m_dimensions.max_level()-1;
 
-                // A unique index for the box
-                const size_t currentIndex = m_dimensions.sub2ind(
-                    baseBox[0].at_level(
-                        m_dimensions.max_level()-1,
-                        dimensions<M>::BOXES_SUBDIVISION
-                    ),
-                    m_dimensions.max_level()-1,
-                    dimensions<M>::BOXES_SUBDIVISION,
-                    dimensions<M>::POINTS_MODE
-                );
-
-                // Add the contributions of all principal boxes.
-                for ( const auto& cornerB : baseBox ) {
-                    auto& cornerBI = grid[cornerB];
-                    for ( const auto& principalBox : principalBoxes ) {
-                        grid[principalBox].m_boxUsedIndex = currentIndex;
-                        for ( const auto& cornerA : principalBox ) {
-                                const auto& cornerAI = grid[cornerA];
-                                cornerBI.m_targetValue += (
-                                    m_f_estimator(
-                                        cornerAI.m_xVal,
-                                        cornerBI.m_xVal
-                                    )*cornerAI.m_inputValue
-                                );
+                for ( size_t i = 0; i < m_nBoxCorners; ++i ) {
+                    auto& targetVal = grid.point_value(targets[i]);
+                    const auto& targetX = plan.position(targets[i]);
+                    // Add the contributions of the adjacent boxes.
+                    for ( const auto nbr : interactions.neighbours(leaves[i]) ) {
+                        if ( grid.box_value(leafLevel, nbr).m_weight == 0 ) continue;
+                        const auto sources = interactions.leaf_corners(nbr);
+                        const auto sourceX = plan.corner_positions(nbr);
+                        for ( size_t k = 0; k < m_nBoxCorners; ++k ) {
+                            targetVal.m_targetValue += gs::vector<A, K>(
+                                grid.point_value(sources[k]).m_inputValue*m_f_estimator(
+                                    sourceX[k],
+                                    targetX
+                                )
+                            );
                         }
                     }
+                    // Add the far field from the local expansion of the leaf.
+                    const auto& leafVal = grid.box_value(leafLevel, leaves[i]);
+                    if ( !leafVal.m_hasLocal ) continue;
+                    targetVal.m_targetValue += gs::vector<A, K>(m_f_estimator.estimate(
+                        leafVal.m_localEstimator,
+                        plan.center(leafLevel, leaves[i]),
+                        targetX
+                    ));
                 }
-
-                // Ensure that non of the stack boxes are used for approximations
-                for ( const auto& principalBox : principalBoxes ) {
-                    box<M> stackBox(principalBox);
-                    for ( size_t lvl = 1; lvl < m_dimensions.max_level(); ++lvl) {
-                        grid[stackBox].m_boxUsedIndex = currentIndex;
-                        stackBox = stackBox.parent();
+            },
+            [&](
+                const box_stack<M, S>& boxStack,
+                grid<M, grid_val, box_val, S>& grid
+            ) {
+                // Only the leaf is computed from the grid, the coarser
+                // boxes are aggregated from their children.
+                const box_handle<M, S> leafBox = grid.handle(boxStack[boxStack.size()-1]);
+                auto& boxVal = grid[leafBox];
+                const auto cornerVals = leaf_corner_vals(leafBox.get_offset(), grid);
+                T weight = 0;
+                for ( const auto& cornerVal : cornerVals.second ) {
+                    T magnitude = 0;
+                    for ( size_t l = 0; l < K; ++l ) {
+                        magnitude = std::max(magnitude, std::abs(cornerVal(l)));
                     }
+                    weight += magnitude;
                 }
-
-                // Iterate all secondary boxes and add contributions
-                for ( auto principalBox : principalBoxes ) {
-                    // For each of the duel boxes
-                    box<M> stackBox(principalBox);
-                    for ( size_t lvl = 1; lvl < m_dimensions.max_level(); ++lvl) {
-                        // Go up the box stack
-                        for ( size_t i=0; i < base_box<M>::m_nCorners; ++i ) {
-                            // For each neighbour box (not in the stack)
-                            const auto nbrBox = stackBox.neighbour(i);
-                            if ( nbrBox.index_in_parent() != stackBox.index_in_parent() ) {
-                                auto& nbrStorage = grid[nbrBox];
-                                // If the contribution has not already bee added.
-                                if ( nbrStorage.m_boxUsedIndex != currentIndex ) {
-                                    // For each of the target points (in the base box)
-                                    for ( const auto& corner : baseBox ) {
-                                        // Add the contributions.
-                                        auto& cornerI = grid[corner];
-                                        cornerI.m_targetValue += m_f_estimator.estimate(
-                                            nbrStorage.m_polyEstimator,  // polynomial
-                                            nbrStorage.m_center,  // center
-                                            cornerI.m_xVal  // corner point
-                                        );
-                                    }
-                                    nbrStorage.m_boxUsedIndex = currentIndex;
-                                }
-                            }
-                        }
-                        stackBox = stackBox.parent();
+                if ( weight == 0 ) return;
+                boxVal.m_weight += weight;
+                const auto polys = m_f_estimator.compute_coefs(
+                    cornerVals.first,
+                    m_plan->center(leafBox),
+                    cornerVals.second
+                );
+                for ( size_t l = 0; l < K; ++l ) {
+                    boxVal.m_polyEstimator[l] += polys[l];
+                }
+            },
+            [&](
+                const box_handle<M, S>& parentBox,
+                grid<M, grid_val, box_val, S>& grid
+            ) {
+                auto& boxVal = grid[parentBox];
+                const auto& center = m_plan->center(parentBox);
+                // Translate the polynomial of every child to the center
+                for ( size_t i = 0; i < m_nBoxCorners; ++i ) {
+                    const auto childBox = grid.subbox(parentBox, i);
+                    const auto& childVal = grid[childBox];
+                    if ( childVal.m_weight == 0 ) continue;
+                    boxVal.m_weight += childVal.m_weight;
+                    const auto translated = m_f_estimator.translate(
+                        childVal.m_polyEstimator,
+                        m_plan->center(childBox),
+                        center
+                    );
+                    for ( size_t l = 0; l < K; ++l ) {
+                        boxVal.m_polyEstimator[l] += translated[l];
                     }
                 }
             },
             [&](
-                const box_stack<M>& boxStack,
-                grid<M, grid_val, box_val>& grid
+                const box_handle<M, S>& localBox,
+                grid<M, grid_val, box_val, S>& grid
             ) {
-                // Compute the center for every box
-                for ( const auto& box : boxStack ) {
-                    auto& boxVal = grid[box];
-                    if ( !boxVal.m_centerComputed ) {
-                        // Compute the center of the box
-                        const auto cornerVals = analytic_multiply::corner_vals(box, grid);
-                        boxVal.m_center = mean(cornerVals.first);
-                        boxVal.m_centerComputed = true;
+                auto& boxVal = grid[localBox];
+                const auto& center = m_plan->center(localBox);
+                // Translate the local expansion of the parent
+                const auto parentBox = grid.parent(localBox);
+                if ( localBox.get_level() > 0 && grid[parentBox].m_hasLocal ) {
+                    const auto& parentVal = grid[parentBox];
+                    boxVal.m_hasLocal = true;
+                    const auto translated = m_f_estimator.translate(
+                        parentVal.m_localEstimator,
+                        m_plan->center(parentBox),
+                        center
+                    );
+                    for ( size_t l = 0; l < K; ++l ) {
+                        boxVal.m_localEstimator[l] += translated[l];
                     }
                 }
-                // Update every box with the parameters of the leaf nodes
-                const auto& leafBox = boxStack[boxStack.size()-1];
-                // Find the corners and values
-                const auto cornerVals = analytic_multiply::corner_vals(leafBox, grid);
-                for ( size_t boxi = 1; boxi < boxStack.size(); ++boxi ) {
-                    auto& boxVal = grid[boxStack[boxi]];
-                    // Update the polynomials.
-                    boxVal.m_polyEstimator += m_f_estimator.compute_coefs(
-                        cornerVals.first,
-                        boxVal.m_center,
-                        cornerVals.second
+                // Translate the polynomials of the interaction list
+                const S level = localBox.get_level();
+                for ( const auto offset : m_plan->get_interactions().far(level, localBox.get_offset()) ) {
+                    const auto& farVal = grid.box_value(level, offset);
+                    if ( farVal.m_weight == 0 ) continue;
+                    const auto& farCenter = m_plan->center(level, offset);
+                    if (
+                        m_tolerance > 0 &&
+                        farVal.m_weight*m_f_estimator.bound(farCenter, center, m_plan->radius(level)) < m_tolerance
+                    ) {
+                        ++boxVal.m_nSkipped;
+                        continue;
+                    }
+                    boxVal.m_hasLocal = true;
+                    const auto translated = m_f_estimator.translate(
+                        farVal.m_polyEstimator,
+                        farCenter,
+                        center
                     );
+                    for ( size_t l = 0; l < K; ++l ) {
+                        boxVal.m_localEstimator[l] += translated[l];
+                    }
                 }
             },
-            dimensions<M>::BOXES_SUBDIVISION
+            dimensions<M, S>::BOXES_SUBDIVISION,
+            plan->get_layout(),
+            resource
         ) {}
 
     /**
-     * \brief Initialise the grid with the input values
+     * \brief Get the plan.
+     */
+    std::shared_ptr<const fmm_plan<M, T, S>> get_plan() const {return m_plan;}
+
+    /**
+     * \brief Bound the working set of each tile of the traversal by the
+     * specified number of bytes, such as the size of a cache.
+     */
+    void set_tile_bytes(const size_t bytes) {m_fmm.set_tile_level(m_fmm.tile_level(bytes));}
+
+    /**
+     * \brief Initialise the grid with one input vector for each lane.
+     *
+     * The inputs are read in place, and so they may be views of any
+     * contiguous buffer.
      */
-    void initialise(const std::vector<T>& init_vec) {
-        if ( m_fmm.grid_size() != init_vec.size() ) {
-            throw std::range_error("Incorrect size");
+    void initialise(const std::array<std::span<const T>, K>& initVecs) {
+        for ( const auto& initVec : initVecs ) {
+            if ( m_fmm.grid_size() != initVec.size() ) {
+                throw std::range_error("Incorrect size");
+            }
         }
         // Initialise the grid
         for ( size_t i = 0; i < m_fmm.grid_size(); ++i ) {
-            m_fmm[i] = grid_val(
-                0.0,  // Output value
-                init_vec[i],  // Input Value
-                gs::vector<double, M>(
-                    m_dimensions.ind2sub(
-                        i, m_dimensions.max_level()-1, dimensions<M>::BOXES_SUBDIVISION
-                    )
-                )   // Position
-            );
+            for ( size_t l = 0; l < K; ++l ) {
+                m_fmm[i].m_inputValue(l) = initVecs[l][i];
+            }
         }
     }
 
     /**
-     * \brief Compute the solution
+     * \brief Initialise the grid with one input vector for each lane.
      */
-    void compute() {m_fmm.compute();}
+    void initialise(const std::array<std::vector<T>, K>& initVecs) {
+        std::array<std::span<const T>, K> initSpans;
+        for ( size_t l = 0; l < K; ++l ) {
+            initSpans[l] = initVecs[l];
+        }
+        initialise(initSpans);
+    }
 
     /**
-     * \brief Return the output
+     * \brief Initialise the grid with the input values
      */
-    std::vector<T> output() const{
-        const size_t size = m_fmm.grid_size();
-        std::vector<T> out;
-        out.reserve(size);
-        for ( size_t i = 0; i < size; ++i ) {
-            out.push_back(m_fmm[i].m_targetValue);
+    void initialise(const std::span<const T> init_vec) requires (K == 1) {
+        initialise(std::array<std::span<const T>, K>{init_vec});
+    }
+
+    /**
+     * \brief Initialise the grid with the input values
+     */
+    void initialise(const std::vector<T>& init_vec) requires (K == 1) {
+        initialise(std::span<const T>(init_vec));
+    }
+
+    /**
+     * \brief Compute the solution, using the specified number of threads.
+     * 
+     * The outputs and the box values of any previous run are zeroed in
+     * place first, and so the inputs can be changed and the solution
+     * recomputed without reallocating the grid or the tree.
+     */
+    void compute(const size_t nThreads = 1) {
+        for ( auto& gridVal : m_fmm ) {
+            gridVal.m_targetValue = gs::vector<A, K>();
+        }
+        m_fmm.clear_boxes();
+        m_fmm.compute(nThreads);
+    }
+
+    /**
+     * \brief The number of interactions between boxes which the last
+     * computation skipped, because they were bounded by the tolerance.
+     */
+    size_t n_skipped() const {
+        size_t nSkipped = 0;
+        for ( const auto& boxVal : m_fmm.box_storage() ) {
+            nSkipped += boxVal.m_nSkipped;
+        }
+        return nSkipped;
+    }
+
+    /**
+     * \brief Write the output of each lane into a buffer of the size
+     * of the grid.
+     */
+    void outputs(const std::array<std::span<T>, K>& outVecs) const {
+        for ( const auto& outVec : outVecs ) {
+            if ( m_fmm.grid_size() != outVec.size() ) {
+                throw std::range_error("Incorrect size");
+            }
+        }
+        for ( size_t i = 0; i < m_fmm.grid_size(); ++i ) {
+            for ( size_t l = 0; l < K; ++l ) {
+                outVecs[l][i] = static_cast<T>(m_fmm[i].m_targetValue(l));
+            }
+        }
+    }
+
+    /**
+     * \brief Return the output of each lane.
+     */
+    std::array<std::vector<T>, K> outputs() const {
+        std::array<std::vector<T>, K> out;
+        std::array<std::span<T>, K> outSpans;
+        for ( size_t l = 0; l < K; ++l ) {
+            out[l].resize(m_fmm.grid_size());
+            outSpans[l] = out[l];
         }
+        outputs(outSpans);
         return out;
     }
+
+    /**
+     * \brief Write the output into a buffer of the size of the grid.
+     */
+    void output(const std::span<T> out) const requires (K == 1) {
+        outputs(std::array<std::span<T>, K>{out});
+    }
+
+    /**
+     * \brief Return the output
+     */
+    std::vector<T> output() const requires (K == 1) {
+        return outputs()[0];
+    }
 };
 }  // namespace gs
 
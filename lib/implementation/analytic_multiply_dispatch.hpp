@@ -0,0 +1,269 @@
+// Copyright 2024 Daniel Beale CC BY-NC-SA 4.0
+#ifndef LIB_IMPLEMENTATION_ANALYTIC_MULTIPLY_DISPATCH_HPP_
+#define LIB_IMPLEMENTATION_ANALYTIC_MULTIPLY_DISPATCH_HPP_
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <memory>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "implementation/analytic_multiply.hpp"
+
+namespace gs {
+template<size_t M>
+/**
+ * \brief The degrees which are instantiated by default.
+ *
+ * The polynomials store a full tensor for each degree, and so the
+ * largest degrees are only available in one and two dimensions.
+ */
+using default_degrees = std::conditional_t<
+    (M < 3),
+    std::index_sequence<2, 4, 6, 8, 10, 12, 15>,
+    std::index_sequence<2, 3, 4, 5, 6>
+>;
+
+template<
+    typename T, size_t M,
+    template < typename, size_t, size_t > class FuncEstimator,
+    size_t K = 1,
+    typename S = uint32_t,
+    class Degrees = default_degrees<M>
+>
+class analytic_multiply_dispatch;
+
+template<
+    typename T, size_t M,
+    template < typename, size_t, size_t > class FuncEstimator,
+    size_t K,
+    typename S,
+    size_t... Degrees
+>
+requires(
+    (M > 0) && (K > 0) && (sizeof...(Degrees) > 0) &&
+    std::is_integral<S>::value && std::is_unsigned<S>::value &&
+    (std::is_constructible<FuncEstimator<T, M, Degrees>, T>::value && ...)
+)
+/**
+ * \brief An analytic_multiply whose degree is chosen at runtime.
+ *
+ * The degree of the polynomial estimates is a template parameter, and so
+ * an analytic_multiply is instantiated for each of a set of degrees. The
+ * smallest degree which reaches the target relative error is selected on
+ * construction, and every call is dispatched to it.
+ *
+ * The error of a degree is measured with a probe: a small multiplication
+ * on a grid with the same number of dimensions and a few unit inputs near
+ * its center, which is compared with the exact product. Its relative error
+ * is the largest error over the largest output. If no degree is adequate
+ * the largest is used.
+ *
+ * The truncation error is largest for boxes of a few standard deviations,
+ * and it grows with the number of levels below them. The probe grid is the
+ * smallest which is wider than sixteen standard deviations, which measures
+ * the same error as any wider grid with the same function, and so its size
+ * only depends on the standard deviation. It has at most 2^15 points, and
+ * so it is cheap in comparison with the multiplication. A wider function is
+ * probed with the standard deviation reduced to fit, which keeps the widths
+ * of the coarse boxes but has fewer levels below them, and so the error of
+ * the selected degree may be larger than the target.
+ *
+ * The points on the edge of the grid are not targets of the multiplication,
+ * and their outputs are zero. The probe only measures the other points, and
+ * so the relative error does not apply to the edge of the grid.
+ *
+ * The template parameters,
+ *      T             - The base type (e.g. double or float).
+ *      M             - The number of dimensions of the grid.
+ *      FuncEstimator - The analytic function estimator, constructed from sigma.
+ *      K             - The number of vectors to multiply.
+ *      S             - The integral type of the indices of the points and boxes.
+ *      Degrees       - The degrees to instantiate, in increasing order.
+ */
+class analytic_multiply_dispatch<T, M, FuncEstimator, K, S, std::index_sequence<Degrees...>> {
+    template<size_t D>
+    using multiply = analytic_multiply<T, M, D, FuncEstimator, K, T, S>;  ///< The multiplication of a degree.
+
+    using multiply_variant = std::variant<std::unique_ptr<multiply<Degrees>>...>;  ///< A multiplication of each of the degrees
+
+    static constexpr std::array<size_t, sizeof...(Degrees)> m_degrees{Degrees...};  ///< The available degrees.
+    static constexpr S m_maxProbeLevel = std::max<S>(2, 15 / M);  ///< The number of levels of the largest probe.
+
+    size_t m_degree;  ///< The selected degree.
+    multiply_variant m_multiply;  ///< The multiplication of the selected degree.
+
+    template<size_t D>
+    /**
+     * \brief Construct the multiplication of the specified degree, if it
+     * is the selected degree.
+     */
+    void construct(const dimensions<M, S>& dims, const T sigma, const T tolerance) {
+        if ( D == m_degree ) {
+            m_multiply = std::make_unique<multiply<D>>(dims, FuncEstimator<T, M, D>(sigma), tolerance);
+        }
+    }
+
+ public:
+    /**
+     * \brief Construct the multiplication with the smallest degree which
+     * reaches the relative error.
+     */
+    analytic_multiply_dispatch(
+        const dimensions<M, S>& dims,
+        const T sigma,
+        const T relError,
+        const T tolerance = 0
+    ): m_degree(select_degree(sigma, relError, tolerance)) {
+        (construct<Degrees>(dims, sigma, tolerance), ...);
+    }
+
+    template<size_t D>
+    /**
+     * \brief The relative error of the specified degree on the probe.
+     */
+    static T probe_error(const T sigma, const T tolerance) {
+        // Enough levels for the coarsest boxes to be wider than the function
+        S level = 2;
+        while ( level < m_maxProbeLevel && static_cast<T>(S(1) << level) < 16*sigma ) {
+            ++level;
+        }
+        const dimensions<M, S> dims(2, level);
+        const auto subDiv = dimensions<M, S>::BOXES_SUBDIVISION;
+        const S width = S(1) << level;
+        // A wider function keeps the widths of the coarse boxes, in standard deviations
+        const T probeSigma = std::min(sigma, static_cast<T>(width) / 16);
+        const S spacing = std::max<S>(1, std::round(probeSigma));
+
+        // Unit inputs at the corners of a box in the middle of the grid
+        const size_t size = dims.max_ind(level-1, subDiv, dimensions<M, S>::POINTS_MODE);
+        std::vector<T> input(size, 0);
+        std::vector<S> sources;
+        for ( size_t k = 0; k < pow<2, M>(); ++k ) {
+            std::array<S, M> sub;
+            sub.fill(width/2);
+            sub = sub + dimensions<M, S>::unitary(k, std::min<S>(spacing, width/2 - 1));
+            sources.push_back(dims.sub2ind(sub, level-1, subDiv));
+            input[sources.back()] = 1;
+        }
+
+        const FuncEstimator<T, M, D> estimator(probeSigma);
+        analytic_multiply<T, M, D, FuncEstimator, 1, T, S> probe(dims, estimator, tolerance);
+        probe.initialise(input);
+        probe.compute();
+        const auto output = probe.output();
+
+        T maxError = 0;
+        T maxValue = 0;
+        for ( size_t i = 0; i < size; ++i ) {
+            // The points on the edge of the grid are not targets
+            const auto sub = dims.ind2sub(i, level-1, subDiv);
+            if ( std::any_of(sub.begin(), sub.end(), [&](const auto s) {return s == 0 || s == width-1;}) ) {
+                continue;
+            }
+            T expected = 0;
+            for ( const auto source : sources ) {
+                expected += estimator(
+                    gs::vector<T, M>(dims.ind2sub(source, level-1, subDiv)),
+                    gs::vector<T, M>(sub)
+                );
+            }
+            maxError = std::max(maxError, std::abs(expected - output[i]));
+            maxValue = std::max(maxValue, std::abs(expected));
+        }
+        return maxError / maxValue;
+    }
+
+    /**
+     * \brief The smallest degree whose probe reaches the relative error,
+     * or the largest degree if there is none.
+     *
+     * The degrees are probed in increasing order until one is adequate. The
+     * largest degree is used when none of the others are, and so it is not
+     * probed.
+     */
+    static size_t select_degree(const T sigma, const T relError, const T tolerance = 0) {
+        size_t degree = 0;
+        ((degree = (
+            degree == 0 &&
+            (Degrees == m_degrees.back() || probe_error<Degrees>(sigma, tolerance) <= relError)
+        ) ? Degrees : degree), ...);
+        return degree;
+    }
+
+    /**
+     * \brief The selected degree.
+     */
+    size_t degree() const {return m_degree;}
+
+    /**
+     * \brief Initialise the grid with one input vector for each lane.
+     */
+    void initialise(const std::array<std::span<const T>, K>& initVecs) {
+        std::visit([&](auto& multiply) {multiply->initialise(initVecs);}, m_multiply);
+    }
+
+    /**
+     * \brief Initialise the grid with one input vector for each lane.
+     */
+    void initialise(const std::array<std::vector<T>, K>& initVecs) {
+        std::visit([&](auto& multiply) {multiply->initialise(initVecs);}, m_multiply);
+    }
+
+    /**
+     * \brief Initialise the grid with the input values
+     */
+    void initialise(const std::span<const T> init_vec) requires (K == 1) {
+        std::visit([&](auto& multiply) {multiply->initialise(init_vec);}, m_multiply);
+    }
+
+    /**
+     * \brief Initialise the grid with the input values
+     */
+    void initialise(const std::vector<T>& init_vec) requires (K == 1) {
+        initialise(std::span<const T>(init_vec));
+    }
+
+    /**
+     * \brief Compute the solution, using the specified number of threads.
+     */
+    void compute(const size_t nThreads = 1) {
+        std::visit([&](auto& multiply) {multiply->compute(nThreads);}, m_multiply);
+    }
+
+    /**
+     * \brief Write the output of each lane into a buffer of the size
+     * of the grid.
+     */
+    void outputs(const std::array<std::span<T>, K>& outVecs) const {
+        std::visit([&](const auto& multiply) {multiply->outputs(outVecs);}, m_multiply);
+    }
+
+    /**
+     * \brief Return the output of each lane.
+     */
+    std::array<std::vector<T>, K> outputs() const {
+        return std::visit([](const auto& multiply) {return multiply->outputs();}, m_multiply);
+    }
+
+    /**
+     * \brief Write the output into a buffer of the size of the grid.
+     */
+    void output(const std::span<T> out) const requires (K == 1) {
+        std::visit([&](const auto& multiply) {multiply->output(out);}, m_multiply);
+    }
+
+    /**
+     * \brief Return the output
+     */
+    std::vector<T> output() const requires (K == 1) {
+        return outputs()[0];
+    }
+};
+}  // namespace gs
+
+#endif  // LIB_IMPLEMENTATION_ANALYTIC_MULTIPLY_DISPATCH_HPP_
@@ -0,0 +1,293 @@
+// Copyright 2024 Daniel Beale CC BY-NC-SA 4.0
+#ifndef LIB_IMPLEMENTATION_SCATTERED_MULTIPLY_HPP_
+#define LIB_IMPLEMENTATION_SCATTERED_MULTIPLY_HPP_
+
+#include <algorithm>
+#include <array>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#include "algorithm/adaptive_tree.hpp"
+#include "estimators/estimator.hpp"
+
+namespace gs {
+template<
+    typename T, size_t M, size_t D,
+    template < typename, size_t, size_t > class FuncEstimator,
+    size_t K = 1,
+    typename S = uint32_t
+>
+requires(
+    (M > 0) && (D > 0) && (K > 0) && estimator<T, M, D, FuncEstimator> &&
+    std::is_floating_point<T>::value &&
+    std::is_integral<S>::value && std::is_unsigned<S>::value
+)
+/**
+ * \brief An approximation of matrix multiplication, when the matrix
+ * is generated by an analytic function of scattered points.
+ *
+ * This is the analytic_multiply for points which do not lie on a grid.
+ * The points are bucketed into an adaptive_tree, and the same estimator
+ * is used for the polynomials of the leaves, the translations between
+ * boxes and the evaluation of the local expansions. The near field of each
+ * leaf is computed exactly. The work and the storage are proportional to
+ * the number of points.
+ *
+ * The tree is immutable and can be shared between multiplications on the
+ * same points. The values are reset in place by each call to compute.
+ *
+ * The template parameters,
+ *      T             - The base type (e.g. double or float).
+ *      M             - The number of dimensions of the points.
+ *      D             - The degree of the polynomial estimates.
+ *      FuncEstimator - The analytic function estimator.
+ *      K             - The number of vectors to multiply.
+ *      S             - The integral type of the indices of the points and boxes.
+ */
+class scattered_multiply {
+ public:
+    /**
+     * \brief A value storage for each box in the tree.
+     */
+    struct box_val {
+        std::array<polynomial<T, M, D>, K> m_polyEstimator;  ///< The polynomials for approximating multiplication.
+        std::array<polynomial<T, M, D>, K> m_localEstimator;  ///< The local expansions of the far field.
+    };
+
+ private:
+    FuncEstimator<T, M, D> m_f_estimator;  ///< The analytic function estimator.
+    std::shared_ptr<const adaptive_tree<M, T, S>> m_tree;  ///< The tree over the points.
+    std::vector<gs::vector<T, K>> m_inputValues;  ///< The input values, in tree order.
+    std::vector<gs::vector<T, K>> m_targetValues;  ///< The output values, in tree order.
+    std::vector<box_val> m_boxValues;  ///< The value of each box in the tree.
+
+    /**
+     * \brief Compute the polynomials of every box, from the leaves upwards.
+     */
+    void upward_pass() {
+        const auto& tree = *m_tree;
+        for ( size_t i = tree.n_nodes(); i-- > 0; ) {
+            const auto& node = tree[i];
+            auto& boxVal = m_boxValues[i];
+            if ( node.is_leaf() ) {
+                // Every point of the leaf is accumulated in one call
+                boxVal.m_polyEstimator = m_f_estimator.compute_coefs(
+                    tree.points(i),
+                    tree.center(i),
+                    std::span<const gs::vector<T, K>>(m_inputValues).subspan(
+                        node.m_firstPoint,
+                        node.m_lastPoint - node.m_firstPoint
+                    )
+                );
+                continue;
+            }
+            // Translate the polynomial of every child to the center
+            for ( S c = node.m_firstChild; c < node.m_lastChild; ++c ) {
+                const auto translated = m_f_estimator.translate(
+                    m_boxValues[c].m_polyEstimator,
+                    tree.center(c),
+                    tree.center(i)
+                );
+                for ( size_t l = 0; l < K; ++l ) {
+                    boxVal.m_polyEstimator[l] += translated[l];
+                }
+            }
+        }
+    }
+
+    /**
+     * \brief Compute the local expansion of every box, from the root downwards.
+     */
+    void downward_pass() {
+        const auto& tree = *m_tree;
+        for ( S i = 0; i < tree.n_nodes(); ++i ) {
+            auto& boxVal = m_boxValues[i];
+            // Translate the local expansion of the parent
+            if ( i > 0 ) {
+                const S parent = tree[i].m_parent;
+                const auto translated = m_f_estimator.translate(
+                    m_boxValues[parent].m_localEstimator,
+                    tree.center(parent),
+                    tree.center(i)
+                );
+                for ( size_t l = 0; l < K; ++l ) {
+                    boxVal.m_localEstimator[l] += translated[l];
+                }
+            }
+            // Translate the polynomials of the far field
+            for ( const auto source : tree.far(i) ) {
+                const auto translated = m_f_estimator.translate(
+                    m_boxValues[source].m_polyEstimator,
+                    tree.center(source),
+                    tree.center(i)
+                );
+                for ( size_t l = 0; l < K; ++l ) {
+                    boxVal.m_localEstimator[l] += translated[l];
+                }
+            }
+        }
+    }
+
+    /**
+     * \brief Evaluate the local expansion and the near field of every leaf.
+     */
+    void evaluate_leaves() {
+        const auto& tree = *m_tree;
+        for ( S i = 0; i < tree.n_nodes(); ++i ) {
+            const auto& node = tree[i];
+            if ( !node.is_leaf() ) continue;
+            for ( S p = node.m_firstPoint; p < node.m_lastPoint; ++p ) {
+                auto& targetVal = m_targetValues[p];
+                targetVal += m_f_estimator.estimate(
+                    m_boxValues[i].m_localEstimator,
+                    tree.center(i),
+                    tree.point(p)
+                );
+                for ( const auto source : tree.near(i) ) {
+                    for ( S q = tree[source].m_firstPoint; q < tree[source].m_lastPoint; ++q ) {
+                        targetVal += m_inputValues[q]*m_f_estimator(tree.point(q), tree.point(p));
+                    }
+                }
+            }
+        }
+    }
+
+ public:
+    scattered_multiply(
+        const std::vector<gs::vector<T, M>>& points,
+        FuncEstimator<T, M, D> f_estimator,
+        const S leafSize = 16,
+        const S maxLevel = 16
+    ):
+        scattered_multiply(
+            std::make_shared<const adaptive_tree<M, T, S>>(points, leafSize, maxLevel),
+            f_estimator
+        ) {}
+
+    /**
+     * \brief Construct using a tree which has already been built.
+     */
+    scattered_multiply(
+        std::shared_ptr<const adaptive_tree<M, T, S>> tree,
+        FuncEstimator<T, M, D> f_estimator
+    ):
+        m_f_estimator(f_estimator),
+        m_tree(tree),
+        m_inputValues(tree->size()),
+        m_targetValues(tree->size()),
+        m_boxValues(tree->n_nodes()) {}
+
+    /**
+     * \brief Get the tree.
+     */
+    std::shared_ptr<const adaptive_tree<M, T, S>> get_tree() const {return m_tree;}
+
+    /**
+     * \brief Initialise the points with one input vector for each lane.
+     *
+     * The values are in the order of the points used to build the tree.
+     * The inputs are read in place, and so they may be views of any
+     * contiguous buffer.
+     */
+    void initialise(const std::array<std::span<const T>, K>& initVecs) {
+        for ( const auto& initVec : initVecs ) {
+            if ( m_tree->size() != initVec.size() ) {
+                throw std::range_error("Incorrect size");
+            }
+        }
+        for ( S p = 0; p < m_tree->size(); ++p ) {
+            for ( size_t l = 0; l < K; ++l ) {
+                m_inputValues[p](l) = initVecs[l][m_tree->order(p)];
+            }
+        }
+    }
+
+    /**
+     * \brief Initialise the points with one input vector for each lane.
+     */
+    void initialise(const std::array<std::vector<T>, K>& initVecs) {
+        std::array<std::span<const T>, K> initSpans;
+        for ( size_t l = 0; l < K; ++l ) {
+            initSpans[l] = initVecs[l];
+        }
+        initialise(initSpans);
+    }
+
+    /**
+     * \brief Initialise the points with the input values
+     */
+    void initialise(const std::span<const T> init_vec) requires (K == 1) {
+        initialise(std::array<std::span<const T>, K>{init_vec});
+    }
+
+    /**
+     * \brief Initialise the points with the input values
+     */
+    void initialise(const std::vector<T>& init_vec) requires (K == 1) {
+        initialise(std::span<const T>(init_vec));
+    }
+
+    /**
+     * \brief Compute the solution.
+     *
+     * The outputs and the box values of any previous run are zeroed in
+     * place first.
+     */
+    void compute() {
+        std::fill(m_targetValues.begin(), m_targetValues.end(), gs::vector<T, K>());
+        std::fill(m_boxValues.begin(), m_boxValues.end(), box_val());
+        upward_pass();
+        downward_pass();
+        evaluate_leaves();
+    }
+
+    /**
+     * \brief Write the output of each lane into a buffer of the number of
+     * points, in the original order of the points.
+     */
+    void outputs(const std::array<std::span<T>, K>& outVecs) const {
+        for ( const auto& outVec : outVecs ) {
+            if ( m_tree->size() != outVec.size() ) {
+                throw std::range_error("Incorrect size");
+            }
+        }
+        for ( S p = 0; p < m_tree->size(); ++p ) {
+            for ( size_t l = 0; l < K; ++l ) {
+                outVecs[l][m_tree->order(p)] = m_targetValues[p](l);
+            }
+        }
+    }
+
+    /**
+     * \brief Return the output of each lane, in the original order of the points.
+     */
+    std::array<std::vector<T>, K> outputs() const {
+        std::array<std::vector<T>, K> out;
+        std::array<std::span<T>, K> outSpans;
+        for ( size_t l = 0; l < K; ++l ) {
+            out[l].resize(m_tree->size());
+            outSpans[l] = out[l];
+        }
+        outputs(outSpans);
+        return out;
+    }
+
+    /**
+     * \brief Write the output into a buffer of the number of points.
+     */
+    void output(const std::span<T> out) const requires (K == 1) {
+        outputs(std::array<std::span<T>, K>{out});
+    }
+
+    /**
+     * \brief Return the output
+     */
+    std::vector<T> output() const requires (K == 1) {
+        return outputs()[0];
+    }
+};
+}  // namespace gs
+
+#endif  // LIB_IMPLEMENTATION_SCATTERED_MULTIPLY_HPP_
@@ -46,6 +46,8 @@ class polynomial : public polynomial<T, N, D-1>{
      * The parameters a computed as the sum of the inner 
      * products of the weighted vectors. Computing the parameters
      * in this way, is a principle component of the Taylor's expansion.
+     * The sums are added to the current parameters, so that the
+     * vectors can be filled in several calls.
      */
     void fill(
         const std::array<gs::vector<T, N>, K>& vectorVals,
@@ -69,6 +71,13 @@ class polynomial : public polynomial<T, N, D-1>{
     const equi_tensor<T, D, N>& coeffs() const {
         return m_coeff;
     }
+    /**
+     * \brief Return the modifiable coefficients of the polynomial
+     * at the current degree.
+     */
+    equi_tensor<T, D, N>& coeffs() {
+        return m_coeff;
+    }
     /**
      * \brief Add another polynomial.
      */
@@ -77,6 +86,14 @@ class polynomial : public polynomial<T, N, D-1>{
         polynomial<T, N, D-1>::operator+=(other);
         return *this;
     }
+    /**
+     * \brief Multiply by a constant.
+     */
+    const polynomial<T, N, D>& operator*=(const T val) {
+        m_coeff *= val;
+        polynomial<T, N, D-1>::operator*=(val);
+        return *this;
+    }
 };
 
 template<typename T, size_t N>
@@ -110,11 +127,19 @@ class polynomial<T, N, 2>: public polynomial<T, N, 1> {
     const matrix<T, N, N>& coeffs() const {
         return m_coeff;
     }
+    matrix<T, N, N>& coeffs() {
+        return m_coeff;
+    }
     const polynomial<T, N, 2>& operator+=(const polynomial<T, N, 2>& other) {
         m_coeff += other.m_coeff;
         polynomial<T, N, 1>::operator+=(other);
         return *this;
     }
+    const polynomial<T, N, 2>& operator*=(const T val) {
+        m_coeff *= val;
+        polynomial<T, N, 1>::operator*=(val);
+        return *this;
+    }
 };
 
 template<typename T, size_t N>
@@ -148,11 +173,19 @@ class polynomial<T, N, 1>: public polynomial<T, N, 0> {
     const gs::vector<T, N>& coeffs() const {
         return m_coeff;
     }
+    gs::vector<T, N>& coeffs() {
+        return m_coeff;
+    }
     const polynomial<T, N, 1>& operator+=(const polynomial<T, N, 1>& other) {
         m_coeff += other.m_coeff;
         polynomial<T, N, 0>::operator+=(other);
         return *this;
     }
+    const polynomial<T, N, 1>& operator*=(const T val) {
+        m_coeff *= val;
+        polynomial<T, N, 0>::operator*=(val);
+        return *this;
+    }
 };
 
 template<typename T, size_t N>
@@ -175,7 +208,6 @@ class polynomial<T, N, 0> {
         const std::array<gs::vector<T, N>, K>&,
         const std::array<T, K>& tVals
     ) {
-        m_coeff = 0.0;
         for ( size_t k = 0; k < K; ++k ) {
             m_coeff += tVals[k];
         }
@@ -186,11 +218,187 @@ class polynomial<T, N, 0> {
     const T& coeffs() const {
         return m_coeff;
     }
+    T& coeffs() {
+        return m_coeff;
+    }
     const polynomial<T, N, 0>& operator+=(const polynomial<T, N, 0>& other) {
         m_coeff += other.m_coeff;
         return *this;
     }
+    const polynomial<T, N, 0>& operator*=(const T val) {
+        m_coeff *= val;
+        return *this;
+    }
 };
+template<size_t K, typename T, size_t N, size_t D>
+/**
+ * \brief The ith coefficient of the specified degree, in the order of
+ * the elements of its tensor.
+ */
+T& coefficient(polynomial<T, N, D>& poly, [[maybe_unused]] const size_t i) {
+    auto& coeffs = static_cast<polynomial<T, N, K>&>(poly).coeffs();
+    if constexpr ( K == 0 ) {
+        return coeffs;
+    } else {
+        gs::vector<T, pow<N, K>()>& vec = coeffs;
+        return vec(i);
+    }
+}
+
+template<size_t K, typename T, size_t N, size_t D>
+/**
+ * \brief The ith coefficient of the specified degree, in the order of
+ * the elements of its tensor.
+ */
+const T& coefficient(const polynomial<T, N, D>& poly, [[maybe_unused]] const size_t i) {
+    const auto& coeffs = static_cast<const polynomial<T, N, K>&>(poly).coeffs();
+    if constexpr ( K == 0 ) {
+        return coeffs;
+    } else {
+        const gs::vector<T, pow<N, K>()>& vec = coeffs;
+        return vec(i);
+    }
+}
+
+template<typename T, size_t N, size_t D, size_t K = D>
+/**
+ * \brief Shift one more factor of the coefficients of each degree which
+ * has at least the specified number of factors.
+ *
+ * The coefficients of degree K with l shifted factors are those with l-1
+ * shifted factors, less the shift times the coefficients of degree K-1
+ * with l-1 shifted factors. The degrees are visited from the highest, and
+ * so the coefficients of degree K-1 have not yet been shifted again.
+ */
+void shift_factor(polynomial<T, N, D>& poly, const gs::vector<T, N>& shift, const size_t l) {
+    if constexpr ( K > 0 ) {
+        if ( K < l ) {
+            return;
+        }
+        size_t stride = 1;
+        for ( size_t j = 1; j < l; ++j ) stride *= N;
+        // The index is split about the shifted factor
+        size_t i = 0;
+        for ( size_t high = 0; high < pow<N, K>() / (stride*N); ++high ) {
+            for ( size_t factor = 0; factor < N; ++factor ) {
+                for ( size_t low = 0; low < stride; ++low, ++i ) {
+                    coefficient<K>(poly, i) -= shift(factor)*coefficient<K-1>(poly, high*stride + low);
+                }
+            }
+        }
+        shift_factor<T, N, D, K-1>(poly, shift, l);
+    }
+}
+
+template<typename T, size_t N, size_t D>
+/**
+ * \brief Re-centre the polynomial.
+ * 
+ * Return the polynomial which would have been filled by the same
+ * weighted vectors, after each of them had been shifted by -shift.
+ * The coefficients of degree k are,
+ *          k
+ *   C'_k = sum (k choose j) sym(C_j (x) (-shift)^(k-j))
+ *          j=0
+ * which is exact, so the coefficients computed about one center
+ * can be moved to another without revisiting the vectors. The sum
+ * is computed in place, by replacing one factor of every degree at
+ * a time with a shifted one.
+ */
+polynomial<T, N, D> recentre(
+    const polynomial<T, N, D>& poly,
+    const gs::vector<T, N>& shift
+) {
+    polynomial<T, N, D> ret = poly;
+    for ( size_t l = 1; l <= D; ++l ) {
+        shift_factor(ret, shift, l);
+    }
+    return ret;
+}
+
+template<typename T, size_t N, size_t D, size_t J>
+/**
+ * \brief Contract the tensor of degree J+1 in the scratch with u, and
+ * add it to the coefficients of degree J and below.
+ *
+ * The contraction is in place, since each element is written after the
+ * elements it depends on have been read.
+ */
+void add_contractions(
+    std::array<T, pow<N, D-1>()>& scratch,
+    const gs::vector<T, N>& u,
+    const T coef,
+    const size_t m,
+    polynomial<T, N, D>& ret
+) {
+    const T nextCoef = coef / m;
+    for ( size_t i = 0; i < pow<N, J>(); ++i ) {
+        T val = 0;
+        for ( size_t a = 0; a < N; ++a ) {
+            val += scratch[i*N + a]*u(a);
+        }
+        scratch[i] = val;
+        coefficient<J>(ret, i) += nextCoef*val;
+    }
+    if constexpr ( J > 0 ) {
+        add_contractions<T, N, D, J-1>(scratch, u, nextCoef, m+1, ret);
+    }
+}
+
+template<typename T, size_t N, size_t D, size_t K = D>
+/**
+ * \brief Add the contractions of the coefficients of each degree to the
+ * lower degrees.
+ */
+void reweight_degree(
+    const polynomial<T, N, D>& poly,
+    const gs::vector<T, N>& u,
+    std::array<T, pow<N, D-1>()>& scratch,
+    polynomial<T, N, D>& ret
+) {
+    if constexpr ( K > 0 ) {
+        // The first contraction reads the coefficients of the polynomial
+        for ( size_t i = 0; i < pow<N, K-1>(); ++i ) {
+            T val = 0;
+            for ( size_t a = 0; a < N; ++a ) {
+                val += coefficient<K>(poly, i*N + a)*u(a);
+            }
+            scratch[i] = val;
+            coefficient<K-1>(ret, i) += val;
+        }
+        if constexpr ( K > 1 ) {
+            add_contractions<T, N, D, K-2>(scratch, u, 1, 2, ret);
+        }
+        reweight_degree<T, N, D, K-1>(poly, u, scratch, ret);
+    }
+}
+
+template<typename T, size_t N, size_t D>
+/**
+ * \brief Re-weight the polynomial by an exponential.
+ * 
+ * Return an approximation to the polynomial which would have been
+ * filled by the same vectors x, after each weight had been multiplied
+ * by exp(u^T x). The exponential is expanded as a series, and the
+ * coefficients of degree k are,
+ *          D-k
+ *   C'_k = sum (1/m!) C_(k+m) contracted m times with u,
+ *          m=0
+ * which is truncated at the degree of the polynomial. The contractions
+ * are computed in a scratch array on the stack, which is the size of
+ * the coefficients of degree D-1.
+ */
+polynomial<T, N, D> exp_reweight(
+    const polynomial<T, N, D>& poly,
+    const gs::vector<T, N>& u
+) {
+    polynomial<T, N, D> ret = poly;
+    if constexpr ( D > 0 ) {
+        std::array<T, pow<N, D-1>()> scratch;
+        reweight_degree(poly, u, scratch, ret);
+    }
+    return ret;
+}
 }  // namespace gs
 
 #endif  // LIB_MATH_POLYNOMIAL_HPP_
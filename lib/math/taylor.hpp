@@ -2,6 +2,8 @@
 #ifndef LIB_MATH_TAYLOR_HPP_
 #define LIB_MATH_TAYLOR_HPP_
 
+#include <array>
+
 #include "math/polynomial.hpp"
 #include "math/vector.hpp"
 
@@ -109,6 +111,35 @@ class taylor {
             );
         }
     }
+
+    template<size_t L, size_t K = D>
+    /**
+     * \brief Produce the Taylor estimate for several polynomials at once.
+     * 
+     * Each of the polynomials is estimated as in the single polynomial
+     * case, but the derivatives of the function are only computed once,
+     * and are shared between all of them.
+     */
+    gs::vector<T, L> estimate(
+        const std::array<polynomial<T, M, D>, L>& polyCoefs,
+        const gs::vector<T, M>& cx,
+        const gs::vector<T, M>& y
+    ) const {
+        const auto funcVal = static_cast<F<T, M, K>>(m_function)(cx, y - cx);
+        gs::vector<T, L> ret;
+        for ( size_t l = 0; l < L; ++l ) {
+            const auto& polyCoefsRef = static_cast<const polynomial<T, M, K>&>(polyCoefs[l]);
+            if constexpr ( K == 0 ) {
+                ret(l) = funcVal*polyCoefsRef.coeffs();
+            } else {
+                ret(l) = (1.0/factorial<K>())*polyCoefsRef.coeffs().dot(funcVal);
+            }
+        }
+        if constexpr ( K > 0 ) {
+            ret += estimate<L, K-1>(polyCoefs, cx, y);
+        }
+        return ret;
+    }
 };
 }  // namespace gs
 
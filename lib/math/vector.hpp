@@ -40,6 +40,12 @@ class vector {
             m_array[i] = static_cast<T>(arr[i]);
         }
     }
+    template<typename S>
+    explicit vector(const vector<S, M>& other) {
+        for ( size_t i = 0; i < M; ++i ) {
+            m_array[i] = static_cast<T>(other(i));
+        }
+    }
 
     T& operator()(const size_t i) {return m_array[i];}  ///< Access the ith element of the vector
     const T& operator()(const size_t i) const {return m_array[i];}   ///< Access the ith element of the vector
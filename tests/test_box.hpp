@@ -6,6 +6,8 @@
 #include <set>
 
 #include "base/box.hpp"
+#include "base/box_handle.hpp"
+#include "base/compact_box.hpp"
 #include "base/tools.hpp"
 #include "base/box_stack_iterator.hpp"
 
@@ -328,4 +330,85 @@ int test_box_parents_3d() {
     return retVal;
 }
 
+int test_box_handle() {
+    std::cout << "Test box handle" << std::endl;
+    int retVal = 0;
+
+    const size_t nDims = 2;
+    const uint32_t maxLevel = 4;
+    using handle = gs::box_handle<nDims>;
+    const auto subDiv = gs::dimensions<nDims>::BOXES_SUBDIVISION;
+
+    // The handle navigates in the same way as the box, with and without
+    // the power of two conversions.
+    for ( const auto& dims : {gs::dimensions<nDims>({2, 4}, maxLevel), gs::dimensions<nDims>({4, 6}, maxLevel)} ) {
+        for ( uint32_t level = 0; level+1 < maxLevel; ++level ) {
+            for ( uint32_t i = 0; i < dims.max_ind(level, subDiv, gs::dimensions<nDims>::BOXES_MODE); ++i ) {
+                const handle boxHandle(level, i);
+                const gs::box<nDims> boxVal(dims, level, subDiv, i);
+                retVal += ASSERT_BOOL(boxHandle.to_box(dims, subDiv) == boxVal);
+                retVal += ASSERT_BOOL(boxHandle.index_in_parent(dims, subDiv) == boxVal.index_in_parent());
+                retVal += ASSERT_BOOL(boxHandle.parent(dims, subDiv).to_box(dims, subDiv) == boxVal.parent());
+                for ( uint32_t j = 0; j < handle::m_nCorners; ++j ) {
+                    retVal += ASSERT_BOOL(boxHandle.subbox(j, dims, subDiv).to_box(dims, subDiv) == boxVal.subbox(j));
+                    if ( level > 0 ) {
+                        retVal += ASSERT_BOOL(boxHandle.neighbour(j, dims, subDiv).to_box(dims, subDiv) == boxVal.neighbour(j));
+                    }
+                }
+            }
+        }
+    }
+    return retVal;
+}
+
+int test_compact_box() {
+    std::cout << "Test compact box" << std::endl;
+    int retVal = 0;
+
+    const size_t nDims = 2;
+    const uint32_t maxLevel = 4;
+    using handle = gs::box_handle<nDims>;
+    using subdivision_type = gs::dimensions<nDims>::subdivision_type;
+    const auto boxesMode = gs::dimensions<nDims>::BOXES_MODE;
+
+    retVal += ASSERT_BOOL(sizeof(gs::compact_box<3>) < sizeof(gs::box<3>)/4);
+
+    // The dimensions are held by address, and so a temporary is rejected
+    static_assert(!std::is_constructible_v<gs::compact_box<nDims>, gs::dimensions<nDims>, uint32_t, subdivision_type>);
+    static_assert(std::is_constructible_v<gs::compact_box<nDims>, const gs::dimensions<nDims>&, uint32_t, subdivision_type>);
+    static_assert(!std::is_constructible_v<gs::box_stack_iterator<nDims>, gs::dimensions<nDims>, subdivision_type>);
+    static_assert(std::is_constructible_v<gs::box_stack_iterator<nDims>, const gs::dimensions<nDims>&, subdivision_type>);
+
+    // The offset of a box is row-major, and that of a handle is a position in
+    // the storage, and so the handle of a box is only found by the grid
+    static_assert(!std::is_convertible_v<gs::compact_box<nDims>, handle>);
+    static_assert(!std::is_constructible_v<handle, gs::compact_box<nDims>>);
+    static_assert(!std::is_constructible_v<handle, gs::box<nDims>>);
+
+    // The compact box has the same corners and navigation as the box
+    const std::array<std::pair<gs::dimensions<nDims>, subdivision_type>, 2> grids{
+        std::make_pair(gs::dimensions<nDims>({2, 4}, maxLevel), gs::dimensions<nDims>::BOXES_SUBDIVISION),
+        std::make_pair(gs::dimensions<nDims>({3, 5}, maxLevel), gs::dimensions<nDims>::POINTS_SUBDIVISION)
+    };
+    for ( const auto& [dims, subDiv] : grids ) {
+        for ( uint32_t level = 0; level+1 < maxLevel; ++level ) {
+            for ( uint32_t i = 0; i < dims.max_ind(level, subDiv, boxesMode); ++i ) {
+                const gs::compact_box<nDims> compactBox(dims, level, subDiv, i);
+                const gs::box<nDims> boxVal(dims, level, subDiv, i);
+                retVal += ASSERT_BOOL(compactBox.get_offset() == i);
+                retVal += ASSERT_BOOL(compactBox.to_box() == boxVal);
+                for ( uint32_t j = 0; j < gs::compact_box<nDims>::m_nCorners; ++j ) {
+                    const std::array<uint32_t, nDims> corner = compactBox[j];
+                    const std::array<uint32_t, nDims> expected = boxVal[j];
+                    retVal += ASSERT_BOOL(corner == expected);
+                    retVal += ASSERT_BOOL(compactBox.subbox(j).to_box() == boxVal.subbox(j));
+                }
+                retVal += ASSERT_BOOL(compactBox.parent().to_box() == boxVal.parent());
+                retVal += ASSERT_BOOL(compactBox.index_in_parent() == boxVal.index_in_parent());
+            }
+        }
+    }
+    return retVal;
+}
+
 #endif  // TESTS_TEST_BOX_HPP_
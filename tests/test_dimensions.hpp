@@ -2,9 +2,12 @@
 #ifndef TESTS_TEST_DIMENSIONS_HPP_
 #define TESTS_TEST_DIMENSIONS_HPP_
 
+#include <vector>
+
 #include "base/dimensions.hpp"
 #include "base/tools.hpp"
 #include "base/index.hpp"
+#include "base/box.hpp"
 
 int test_dimensions_sub2ind() {
     std::cout << "Test dimensions sub2ind" << std::endl;
@@ -38,6 +41,190 @@ int test_dimensions_sub2ind_inversion() {
     return retVal;
 }
 
+int test_dimensions_power_of_two() {
+    std::cout << "Test dimensions power of two" << std::endl;
+    using dims_type = gs::dimensions<3>;
+    const dims_type dims({2, 4, 8}, 4);
+    int retVal = 0;
+    retVal += ASSERT_BOOL(dims.shifted(dims_type::BOXES_SUBDIVISION, dims_type::POINTS_MODE));
+    retVal += ASSERT_BOOL(!dims.shifted(dims_type::POINTS_SUBDIVISION, dims_type::POINTS_MODE));
+    retVal += ASSERT_BOOL(!dims_type({3, 4, 8}, 4).shifted(dims_type::BOXES_SUBDIVISION, dims_type::POINTS_MODE));
+    retVal += ASSERT_BOOL(!dims_type(1, 4).shifted(dims_type::BOXES_SUBDIVISION, dims_type::POINTS_MODE));
+
+    // The shifted conversions agree with the division at every level
+    const std::array<dims_type::modality, 3> modes{
+        dims_type::BOXES_MODE, dims_type::POINTS_MODE, dims_type::LOCAL_BOXES
+    };
+    const std::array<dims_type::conversion, 4> convs{
+        dims_type::NO_CONV, dims_type::POINTS_CONV, dims_type::BOXES_CONV, dims_type::LOCAL_CONV
+    };
+    const auto subDiv = dims_type::BOXES_SUBDIVISION;
+    for ( uint32_t level = 0; level < 4; ++level ) {
+        for ( const auto mode : modes ) {
+            const auto levelDims = dims.level_dims(level, subDiv, mode);
+            const uint32_t size = dims.max_ind(level, subDiv, mode);
+            for ( uint32_t i = 0; i < size; ++i ) {
+                const auto sub = dims.ind2sub(i, level, subDiv, mode);
+                retVal += ASSERT_BOOL(sub == dims_type::ind2sub(i, levelDims));
+                retVal += ASSERT_BOOL(dims.sub2ind(sub, level, subDiv, mode) == i);
+                for ( const auto conv : convs ) {
+                    const auto convSub = dims.ind2sub(i, level, subDiv, mode, conv);
+                    auto expected = dims_type::ind2sub(i, levelDims);
+                    for ( auto& ind : expected ) {
+                        if ( conv == dims_type::POINTS_CONV ) ind *= 2;
+                        if ( conv == dims_type::BOXES_CONV ) ind /= 2;
+                        if ( conv == dims_type::LOCAL_CONV ) ind %= 2;
+                    }
+                    retVal += ASSERT_BOOL(convSub == expected);
+                }
+            }
+        }
+        // The corner point of each box, and the box and local box of each point
+        const auto boxDims = dims.level_dims(level, subDiv, dims_type::BOXES_MODE);
+        const auto pointDims = dims.level_dims(level, subDiv, dims_type::POINTS_MODE);
+        const auto localDims = dims.level_dims(level, subDiv, dims_type::LOCAL_BOXES);
+        for ( uint32_t i = 0; i < dims.max_ind(level, subDiv, dims_type::BOXES_MODE); ++i ) {
+            const auto sub = dims.ind2sub(i, level, subDiv, dims_type::BOXES_MODE);
+            std::array<uint32_t, 3> corner;
+            for ( uint32_t d = 0; d < 3; ++d ) corner[d] = sub[d]*2;
+            retVal += ASSERT_BOOL(
+                dims.sub2ind(sub, level, subDiv, dims_type::BOXES_MODE, dims_type::POINTS_CONV) ==
+                dims_type::sub2ind(corner, pointDims)
+            );
+        }
+        for ( uint32_t i = 0; i < dims.max_ind(level, subDiv, dims_type::POINTS_MODE); ++i ) {
+            const auto sub = dims.ind2sub(i, level, subDiv, dims_type::POINTS_MODE);
+            std::array<uint32_t, 3> parent, local;
+            for ( uint32_t d = 0; d < 3; ++d ) {
+                parent[d] = sub[d]/2;
+                local[d] = sub[d] % localDims[d];
+            }
+            retVal += ASSERT_BOOL(
+                dims.sub2ind(sub, level, subDiv, dims_type::POINTS_MODE, dims_type::BOXES_CONV) ==
+                dims_type::sub2ind(parent, boxDims)
+            );
+            retVal += ASSERT_BOOL(
+                dims.sub2ind(sub, level, subDiv, dims_type::POINTS_MODE, dims_type::LOCAL_CONV) ==
+                dims_type::sub2ind(local, localDims)
+            );
+        }
+    }
+    return retVal;
+}
+
+int test_dimensions_batched() {
+    std::cout << "Test dimensions batched" << std::endl;
+    using dims_type = gs::dimensions<3>;
+    int retVal = 0;
+
+    // The batched conversions agree with the scalar ones, with and without
+    // the power of two conversions.
+    for ( const auto& dims : {dims_type({2, 4, 8}, 4), dims_type({3, 4, 5}, 4)} ) {
+        for ( const auto subDiv : {dims_type::POINTS_SUBDIVISION, dims_type::BOXES_SUBDIVISION} ) {
+            for ( const auto mode : {dims_type::BOXES_MODE, dims_type::POINTS_MODE} ) {
+                const uint32_t level = 2;
+                const uint32_t size = dims.max_ind(level, subDiv, mode);
+                std::vector<uint32_t> inds(size);
+                for ( uint32_t i = 0; i < size; ++i ) inds[i] = i;
+                std::array<std::vector<uint32_t>, 3> subs;
+                for ( auto& sub : subs ) sub.resize(size);
+                dims.ind2sub(inds, {subs[0], subs[1], subs[2]}, level, subDiv, mode);
+                for ( uint32_t i = 0; i < size; ++i ) {
+                    const std::array<uint32_t, 3> sub{subs[0][i], subs[1][i], subs[2][i]};
+                    retVal += ASSERT_BOOL(sub == dims.ind2sub(i, level, subDiv, mode));
+                }
+                std::vector<uint32_t> roundTrip(size);
+                dims.sub2ind({subs[0], subs[1], subs[2]}, roundTrip, level, subDiv, mode);
+                retVal += ASSERT_BOOL(roundTrip == inds);
+            }
+        }
+    }
+    return retVal;
+}
+
+int test_dimensions_max_ind_overflow() {
+    std::cout << "Test dimensions max_ind overflow" << std::endl;
+    int retVal = 0;
+    const auto subDiv = gs::dimensions<3>::BOXES_SUBDIVISION;
+    const auto mode = gs::dimensions<3>::POINTS_MODE;
+
+    // A 3D grid at level 11 has 2^36 points
+    const gs::dimensions<3> narrow(2, 12);
+    bool thrown = false;
+    try {
+        narrow.max_ind(11, subDiv, mode);
+    } catch ( const std::overflow_error& ) {
+        thrown = true;
+    }
+    retVal += ASSERT_BOOL(thrown);
+    retVal += ASSERT_BOOL(narrow.max_ind(9, subDiv, mode) == (uint32_t(1) << 30));
+
+    using wide_dimensions = gs::dimensions<3, uint64_t>;
+    const wide_dimensions wide(2, 12);
+    const auto wideSubDiv = wide_dimensions::BOXES_SUBDIVISION;
+    retVal += ASSERT_BOOL(wide.max_ind(11, wideSubDiv, wide_dimensions::POINTS_MODE) == (uint64_t(1) << 36));
+    const uint64_t ind = wide.max_ind(11, wideSubDiv, wide_dimensions::POINTS_MODE) - 1;
+    retVal += ASSERT_BOOL(wide.sub2ind(wide.ind2sub(ind, 11, wideSubDiv), 11, wideSubDiv) == ind);
+    return retVal;
+}
+
+int test_dimensions_sub2morton() {
+    std::cout << "Test dimensions sub2morton" << std::endl;
+    const uint32_t maxLevel = 3;
+    const auto subDiv = gs::dimensions<3>::BOXES_SUBDIVISION;
+    gs::dimensions<3> dims({4, 2, 6}, maxLevel);
+    int retVal = 0;
+
+    // The Morton index of the points is a permutation, and is inverted
+    const uint32_t leafLevel = maxLevel-1;
+    const uint32_t nPoints = dims.max_ind(leafLevel, subDiv, gs::dimensions<3>::POINTS_MODE);
+    std::vector<uint32_t> counts(nPoints, 0);
+    for ( uint32_t i = 0; i < nPoints; ++i ) {
+        const auto sub = dims.ind2sub(i, leafLevel, subDiv);
+        const uint32_t morton = dims.sub2morton(sub, leafLevel);
+        retVal += ASSERT_BOOL(morton < nPoints);
+        retVal += ASSERT_BOOL(dims.morton2sub(morton, leafLevel) == sub);
+        if ( morton < nPoints ) ++counts[morton];
+    }
+    for ( const auto count : counts ) {
+        retVal += ASSERT_BOOL(count == 1);
+    }
+
+    // The corners of each finest box are contiguous
+    const uint32_t nLeaves = dims.max_ind(leafLevel, subDiv, gs::dimensions<3>::BOXES_MODE);
+    for ( uint32_t i = 0; i < nLeaves; ++i ) {
+        const gs::box<3> leafBox(dims, leafLevel, subDiv, i);
+        uint32_t first = nPoints;
+        uint32_t last = 0;
+        for ( const auto& corner : leafBox ) {
+            const uint32_t morton = dims.sub2morton(corner, leafLevel);
+            first = std::min(first, morton);
+            last = std::max(last, morton);
+        }
+        retVal += ASSERT_BOOL(first % 8 == 0 && last == first + 7);
+    }
+
+    // The children of each box are contiguous, in the order of their index
+    for ( uint32_t level = 0; level < leafLevel; ++level ) {
+        const uint32_t nBoxes = dims.max_ind(level, subDiv, gs::dimensions<3>::BOXES_MODE);
+        for ( uint32_t i = 0; i < nBoxes; ++i ) {
+            const gs::box<3> parentBox(dims, level, subDiv, i);
+            const auto mode = gs::dimensions<3>::BOXES_MODE;
+            const uint32_t parentMorton = dims.sub2morton(
+                dims.ind2sub(i, level, subDiv, mode), level, mode
+            );
+            for ( uint32_t k = 0; k < 8; ++k ) {
+                const uint32_t offset = parentBox.subbox(k).get_offset();
+                const uint32_t morton = dims.sub2morton(
+                    dims.ind2sub(offset, level+1, subDiv, mode), level+1, mode
+                );
+                retVal += ASSERT_BOOL(morton == 8*parentMorton + k);
+                retVal += ASSERT_BOOL(dims.morton2sub(morton, level+1, mode) == dims.ind2sub(offset, level+1, subDiv, mode));
+            }
+        }
+    }
+    return retVal;
+}
 
 int test_point_convert_topoints_ind2sub() {
     std::cout << "Test boxes to points conversion ind2sub" << std::endl;
@@ -37,4 +37,69 @@ int test_exp_estimator() {
     return retVal;
 }
 
+int test_exp_estimator_translate() {
+    std::cout << "Test exp estimator translate" << std::endl;
+    int retVal = 0;
+
+    gs::exp_squared_est<double, 2, 12> expEst(2.5);
+    const std::array<gs::vector<double, 2>, 4> corners{
+        gs::vector<double, 2>{0.0, 0.0},
+        gs::vector<double, 2>{1.0, 0.0},
+        gs::vector<double, 2>{0.0, 1.0},
+        gs::vector<double, 2>{1.0, 1.0}
+    };
+    const std::array<double, 4> values{1.0, 2.0, -1.0, 0.5};
+    const gs::vector<double, 2> center{0.5, 0.5};
+    const gs::vector<double, 2> newCenter{1.5, 1.5};
+
+    const auto translated = expEst.translate(
+        expEst.compute_coefs<4>(corners, center, values),
+        center,
+        newCenter
+    );
+    const auto direct = expEst.compute_coefs<4>(corners, newCenter, values);
+
+    for ( const auto& y : {gs::vector<double, 2>{3.0, 4.0}, gs::vector<double, 2>{-2.0, 1.0}} ) {
+        double exact = 0;
+        for ( size_t i = 0; i < corners.size(); ++i ) {
+            exact += expEst(corners[i], y)*values[i];
+        }
+        retVal += ASSERT_BOOL(std::abs(expEst.estimate(translated, newCenter, y) - exact) < 1e-4)
+        retVal += ASSERT_BOOL(
+            std::abs(
+                expEst.estimate(translated, newCenter, y) -
+                expEst.estimate(direct, newCenter, y)
+            ) < 1e-4
+        )
+    }
+
+    // Translating several polynomials at once matches translating each of them
+    const std::array<gs::vector<double, 2>, 4> laneValues{
+        gs::vector<double, 2>{1.0, 0.0},
+        gs::vector<double, 2>{2.0, 1.0},
+        gs::vector<double, 2>{-1.0, 3.0},
+        gs::vector<double, 2>{0.5, -2.0}
+    };
+    const auto lanes = expEst.compute_coefs<4, 2>(corners, center, laneValues);
+    const auto translatedLanes = expEst.translate(lanes, center, newCenter);
+    // And the coefficients of a run of vectors match those of an array
+    const auto spanLanes = expEst.compute_coefs(
+        std::span<const gs::vector<double, 2>>(corners),
+        center,
+        std::span<const gs::vector<double, 2>>(laneValues)
+    );
+    for ( size_t l = 0; l < 2; ++l ) {
+        const auto single = expEst.translate(lanes[l], center, newCenter);
+        const gs::vector<double, 2> y{3.0, 4.0};
+        retVal += ASSERT_BOOL(
+            std::abs(expEst.estimate(translatedLanes[l], newCenter, y) - expEst.estimate(single, newCenter, y)) < 1e-12
+        )
+        retVal += ASSERT_BOOL(
+            std::abs(expEst.estimate(spanLanes[l], center, y) - expEst.estimate(lanes[l], center, y)) < 1e-12
+        )
+    }
+
+    return retVal;
+}
+
 #endif  // TESTS_TEST_ESTIMATORS_HPP_
@@ -2,15 +2,97 @@
 #ifndef TESTS_TEST_FMM_HPP_
 #define TESTS_TEST_FMM_HPP_
 
+#include <algorithm>
+#include <array>
+#include <filesystem>
+#include <span>
 #include <vector>
 
 #include "algorithm/fmm.hpp"
+#include "algorithm/interaction_list.hpp"
+#include "algorithm/fmm_plan.hpp"
+#include "algorithm/adaptive_tree.hpp"
+#include "base/mapped_resource.hpp"
 #include "functions/exp_inner.hpp"
 #include "functions/exp_squared.hpp"
 #include "math/taylor.hpp"
 #include "estimators/exp_squared_est.hpp"
 #include "implementation/analytic_multiply.hpp"
+#include "implementation/analytic_multiply_dispatch.hpp"
+#include "implementation/scattered_multiply.hpp"
 
+/**
+ * \brief The grid and function which the multiplication tests share.
+ *
+ * A 16x16 grid, with a squared exponential of standard deviation 2.5
+ * estimated at degree 6.
+ */
+struct fmm_fixture {
+    static constexpr size_t nDims = 2;
+    static constexpr size_t nDegree = 6;
+    static constexpr size_t size = gs::pow<2, 4>()*gs::pow<2, 4>();
+
+    using estimator_type = gs::exp_squared_est<double, nDims, nDegree>;
+    using multiply = gs::analytic_multiply<double, nDims, nDegree, gs::exp_squared_est>;
+
+    const gs::dimensions<nDims> dims = gs::dimensions<nDims>(2, 4);
+    const estimator_type estimator = estimator_type(2.5);
+
+    /**
+     * \brief An input with the values ((i*a) % b) - c.
+     */
+    static std::vector<double> input(const size_t a, const size_t b, const double c) {
+        std::vector<double> inputVec(size);
+        for ( size_t i = 0; i < size; ++i ) {
+            inputVec[i] = static_cast<double>((i*a) % b) - c;
+        }
+        return inputVec;
+    }
+
+    /**
+     * \brief The output of a row-major multiplication of the input.
+     */
+    std::vector<double> product(const std::vector<double>& inputVec, const size_t nThreads = 1) const {
+        multiply analyticMult(dims, estimator);
+        analyticMult.initialise(inputVec);
+        analyticMult.compute(nThreads);
+        return analyticMult.output();
+    }
+};
+
+template<int N, typename S, class Estimator>
+/**
+ * \brief The product of the function with the input at every point of the
+ * finest level, computed directly in O(N^2).
+ */
+std::vector<double> dense_multiply(
+    const gs::dimensions<N, S>& dims,
+    const Estimator& estimator,
+    const std::vector<double>& inputVec
+) {
+    const S level = dims.max_level()-1;
+    const auto subDiv = gs::dimensions<N, S>::BOXES_SUBDIVISION;
+    std::vector<double> expected(inputVec.size(), 0.0);
+    for ( size_t i = 0; i < inputVec.size(); ++i ) {
+        const gs::vector<double, N> target(dims.ind2sub(i, level, subDiv));
+        for ( size_t j = 0; j < inputVec.size(); ++j ) {
+            if ( inputVec[j] == 0 ) continue;
+            expected[i] += estimator(target, gs::vector<double, N>(dims.ind2sub(j, level, subDiv)))*inputVec[j];
+        }
+    }
+    return expected;
+}
+
+/**
+ * \brief Check that the outputs only differ from the reference by rounding.
+ */
+int assert_matches(const std::vector<double>& output, const std::vector<double>& reference) {
+    int retVal = ASSERT_BOOL(output.size() == reference.size());
+    for ( size_t i = 0; i < std::min(output.size(), reference.size()); ++i ) {
+        retVal += ASSERT_BOOL(std::abs(output[i] - reference[i]) < 1e-10*std::abs(reference[i]) + 1e-12);
+    }
+    return retVal;
+}
 
 int testq_fmm_exp2_1d() {
     std::cout << "Test fmm exp2 1d" << std::endl;
@@ -68,6 +150,49 @@ int testq_fmm_exp2_1d() {
     return retVal;
 }
 
+int testq_fmm_exp2_1d_deep() {
+    std::cout << "Test fmm exp2 1d deep" << std::endl;
+    int retVal = 0;
+
+    // Define base types
+    const size_t nDims = 1;
+    const size_t nDegree = 15;
+    const uint32_t maxLevel = 7;
+
+    // Set the standard deviation.
+    const double sigma = 2.0;
+    gs::dimensions<nDims> dims(2, maxLevel);
+    gs::exp_squared_est<double, nDims, nDegree> estimator(sigma);
+
+    // Set up FMM algorithm.
+    gs::analytic_multiply<
+        double, nDims, nDegree, gs::exp_squared_est
+    > analyticMult(dims, estimator);
+
+    // The far field spans several levels of local expansions
+    const size_t size = gs::pow<2, maxLevel>();
+    std::vector<double> inputVec(size, 0.0);
+    for ( size_t i = 0; i < size; ++i ) {
+        inputVec[i] = static_cast<double>((i*7) % 5);
+    }
+    analyticMult.initialise(inputVec);
+    analyticMult.compute();
+    auto output = analyticMult.output();
+
+    for ( size_t i = 1; i < size-1; ++i ) {
+        double expected = 0.0;
+        for ( size_t j = 0; j < size; ++j ) {
+            expected += estimator(
+                gs::vector<double, nDims>{static_cast<double>(i)},
+                gs::vector<double, nDims>{static_cast<double>(j)}
+            )*inputVec[j];
+        }
+        retVal += ASSERT_BOOL(std::abs(expected - output[i]) < 2e-4);
+    }
+
+    return retVal;
+}
+
 int testq_fmm_exp2_2d() {
     std::cout << "Test fmm exp2 2d" << std::endl;
     int retVal = 0;
@@ -140,4 +265,637 @@ int testq_fmm_exp2_2d() {
     return retVal;
 }
 
+int testq_fmm_exp2_2d_threads() {
+    std::cout << "Test fmm exp2 2d threads" << std::endl;
+    int retVal = 0;
+
+    const fmm_fixture fixture;
+    const auto inputVec = fmm_fixture::input(7, 5, 0.0);
+    const auto serial = fixture.product(inputVec);
+    for ( const size_t nThreads : {3, 8} ) {
+        // The upward pass is split into levels rather than visited depth first
+        const auto parallel = fixture.product(inputVec, nThreads);
+        retVal += assert_matches(parallel, serial);
+        // But it must be identical for a fixed number of threads
+        retVal += ASSERT_BOOL(fixture.product(inputVec, nThreads) == parallel);
+    }
+
+    return retVal;
+}
+
+int testq_fmm_exp2_2d_lanes() {
+    std::cout << "Test fmm exp2 2d lanes" << std::endl;
+    int retVal = 0;
+
+    const fmm_fixture fixture;
+    const size_t nLanes = 3;
+    std::array<std::vector<double>, nLanes> inputVecs;
+    for ( size_t l = 0; l < nLanes; ++l ) {
+        inputVecs[l] = fmm_fixture::input(l+3, 7, 3.0);
+    }
+
+    gs::analytic_multiply<
+        double, fmm_fixture::nDims, fmm_fixture::nDegree, gs::exp_squared_est, nLanes
+    > lanesMult(fixture.dims, fixture.estimator);
+    lanesMult.initialise(inputVecs);
+    lanesMult.compute();
+    const auto outputs = lanesMult.outputs();
+
+    // Every lane is the same as a separate multiplication
+    for ( size_t l = 0; l < nLanes; ++l ) {
+        retVal += assert_matches(outputs[l], fixture.product(inputVecs[l]));
+    }
+
+    return retVal;
+}
+
+int testq_fmm_exp2_2d_reuse() {
+    std::cout << "Test fmm exp2 2d reuse" << std::endl;
+    int retVal = 0;
+
+    const fmm_fixture fixture;
+    const size_t size = fmm_fixture::size;
+    const auto inputA = fmm_fixture::input(3, 7, 3.0);
+    const auto inputB = fmm_fixture::input(5, 11, 5.0);
+    const auto outputA = fixture.product(inputA);
+
+    // A multiplication which shares the plan gives the same result
+    fmm_fixture::multiply multA(fixture.dims, fixture.estimator);
+    fmm_fixture::multiply multB(multA.get_plan(), fixture.estimator);
+    multB.initialise(inputB);
+    multB.compute();
+    const auto outputB = multB.output();
+    retVal += assert_matches(outputB, fixture.product(inputB));
+
+    // Computing again gives the same result
+    multA.initialise(inputA);
+    multA.compute();
+    multA.compute();
+    retVal += assert_matches(multA.output(), outputA);
+
+    // Changing the input gives the result of a fresh multiplication
+    multA.initialise(inputB);
+    multA.compute(2);
+    retVal += assert_matches(multA.output(), outputB);
+
+    // Views of a larger buffer are read and written in place
+    std::vector<double> buffer(3*size);
+    std::copy(inputA.begin(), inputA.end(), buffer.begin() + size);
+    multA.initialise(std::span<const double>(buffer).subspan(size, size));
+    multA.compute();
+    multA.output(std::span<double>(buffer).subspan(2*size, size));
+    retVal += ASSERT_BOOL(std::all_of(buffer.begin(), buffer.begin() + size, [](const double x) {return x == 0;}));
+    retVal += assert_matches(std::vector<double>(buffer.begin() + 2*size, buffer.end()), outputA);
+
+    return retVal;
+}
+
+int testq_fmm_exp2_2d_morton() {
+    std::cout << "Test fmm exp2 2d morton" << std::endl;
+    int retVal = 0;
+
+    const fmm_fixture fixture;
+    using multiply = fmm_fixture::multiply;
+    const auto inputVec = fmm_fixture::input(3, 7, 3.0);
+    const auto rowOutput = fixture.product(inputVec);
+
+    // The layout does not change the result, with or without threads
+    multiply mortonMult(
+        fixture.dims, fixture.estimator, 0,
+        gs::grid<fmm_fixture::nDims, multiply::grid_val, multiply::box_val>::MORTON
+    );
+    mortonMult.initialise(inputVec);
+    for ( const size_t nThreads : {1, 3} ) {
+        mortonMult.compute(nThreads);
+        retVal += assert_matches(mortonMult.output(), rowOutput);
+    }
+
+    // The index type does not change the result
+    using wide_multiply = gs::analytic_multiply<
+        double, fmm_fixture::nDims, fmm_fixture::nDegree, gs::exp_squared_est, 1, double, uint64_t
+    >;
+    wide_multiply wideMult(gs::dimensions<fmm_fixture::nDims, uint64_t>(2, 4), fixture.estimator);
+    wideMult.initialise(inputVec);
+    wideMult.compute();
+    retVal += assert_matches(wideMult.output(), rowOutput);
+
+    return retVal;
+}
+
+int testq_fmm_exp2_2d_mapped() {
+    std::cout << "Test fmm exp2 2d mapped" << std::endl;
+    int retVal = 0;
+
+    const fmm_fixture fixture;
+    using multiply = fmm_fixture::multiply;
+    const auto inputVec = fmm_fixture::input(5, 9, 4.0);
+
+    // The storage in files gives the same result as the heap
+    gs::mapped_resource resource(std::filesystem::temp_directory_path().string());
+    multiply mappedMult(
+        fixture.dims, fixture.estimator, 0,
+        gs::grid<fmm_fixture::nDims, multiply::grid_val, multiply::box_val>::MORTON,
+        &resource
+    );
+    mappedMult.initialise(inputVec);
+    mappedMult.compute();
+    retVal += assert_matches(mappedMult.output(), fixture.product(inputVec));
+
+    return retVal;
+}
+
+int testq_fmm_exp2_2d_precision() {
+    std::cout << "Test fmm exp2 2d precision" << std::endl;
+    int retVal = 0;
+
+    // Define base types
+    const size_t nDims = 2;
+    const size_t nDegree = 6;
+
+    // Set the standard deviation.
+    const double sigma = 2.5;
+    gs::dimensions<nDims> dims(2, 5);
+
+    const size_t width = gs::pow<2, 5>();
+    const size_t size = width*width;
+
+    // The largest difference of the float and mixed modes from the double precision path
+    const auto errors = [&](const std::vector<double>& inputVec) {
+        std::vector<float> inputVecF(inputVec.begin(), inputVec.end());
+
+        gs::analytic_multiply<double, nDims, nDegree, gs::exp_squared_est> doubleMult(
+            dims, gs::exp_squared_est<double, nDims, nDegree>(sigma)
+        );
+        doubleMult.initialise(inputVec);
+        doubleMult.compute();
+        const auto doubleOutput = doubleMult.output();
+
+        gs::analytic_multiply<float, nDims, nDegree, gs::exp_squared_est> floatMult(
+            dims, gs::exp_squared_est<float, nDims, nDegree>(sigma)
+        );
+        floatMult.initialise(inputVecF);
+        floatMult.compute();
+        const auto floatOutput = floatMult.output();
+
+        gs::analytic_multiply<float, nDims, nDegree, gs::exp_squared_est, 1, double> mixedMult(
+            dims, gs::exp_squared_est<float, nDims, nDegree>(sigma)
+        );
+        mixedMult.initialise(inputVecF);
+        mixedMult.compute();
+        const auto mixedOutput = mixedMult.output();
+
+        double maxValue = 0;
+        double floatError = 0;
+        double mixedError = 0;
+        for ( size_t i = 0; i < size; ++i ) {
+            maxValue = std::max(maxValue, std::abs(doubleOutput[i]));
+            floatError = std::max(floatError, std::abs(doubleOutput[i] - floatOutput[i]));
+            mixedError = std::max(mixedError, std::abs(doubleOutput[i] - mixedOutput[i]));
+        }
+        std::cout << "    relative error, float: " << floatError / maxValue;
+        std::cout << ", mixed: " << mixedError / maxValue << std::endl;
+        return std::array<double, 3>{maxValue, floatError, mixedError};
+    };
+
+    std::vector<double> inputVec(size);
+    for ( size_t i = 0; i < size; ++i ) {
+        inputVec[i] = static_cast<double>((i*7) % 13) - 6.0;
+    }
+    const auto [maxValue, floatError, mixedError] = errors(inputVec);
+    retVal += ASSERT_BOOL(floatError < 1e-4*maxValue);
+    retVal += ASSERT_BOOL(mixedError < 1e-4*maxValue);
+
+    // Large values of opposite sign on the two halves of the grid, so that the
+    // sums near the middle cancel. Only the sums are widened, and the kernels
+    // and the polynomials are single precision in both modes, but the double
+    // accumulation still has a clearly smaller error.
+    std::vector<double> cancelVec(size);
+    for ( size_t i = 0; i < size; ++i ) {
+        cancelVec[i] = ((i % width < width/2) ? 1000.0 : -1000.0) + inputVec[i];
+    }
+    const auto [cancelValue, cancelFloatError, cancelMixedError] = errors(cancelVec);
+    retVal += ASSERT_BOOL(cancelMixedError < 0.75*cancelFloatError);
+
+    return retVal;
+}
+
+int testq_fmm_exp2_2d_sparse() {
+    std::cout << "Test fmm exp2 2d sparse" << std::endl;
+    int retVal = 0;
+
+    // Define base types
+    const size_t nDims = 2;
+    const size_t nDegree = 8;
+    const uint32_t maxLevel = 5;
+
+    // Set the standard deviation.
+    const double sigma = 2.0;
+    gs::dimensions<nDims> dims(2, maxLevel);
+    gs::exp_squared_est<double, nDims, nDegree> estimator(sigma);
+    const auto subDiv = gs::dimensions<nDims>::BOXES_SUBDIVISION;
+
+    // A few nonzeros, far apart, so that most boxes are empty
+    const size_t size = gs::pow<2, maxLevel>()*gs::pow<2, maxLevel>();
+    std::vector<double> inputVec(size, 0.0);
+    inputVec[dims.sub2ind({5, 6}, maxLevel-1, subDiv)] = 1.0;
+    inputVec[dims.sub2ind({6, 6}, maxLevel-1, subDiv)] = -2.0;
+    inputVec[dims.sub2ind({25, 20}, maxLevel-1, subDiv)] = 1.5;
+    inputVec[dims.sub2ind({12, 27}, maxLevel-1, subDiv)] = 0.5;
+
+    using multiply = gs::analytic_multiply<double, nDims, nDegree, gs::exp_squared_est>;
+    multiply exactMult(dims, estimator);
+    exactMult.initialise(inputVec);
+    exactMult.compute();
+    const auto output = exactMult.output();
+    retVal += ASSERT_BOOL(exactMult.n_skipped() == 0);
+
+    // Skipping the negligible boxes changes each output by very little
+    const double tolerance = 1e-9;
+    multiply prunedMult(exactMult.get_plan(), estimator, tolerance);
+    prunedMult.initialise(inputVec);
+    prunedMult.compute();
+    const auto prunedOutput = prunedMult.output();
+    const size_t nSkipped = prunedMult.n_skipped();
+    std::cout << "    skipped interactions: " << nSkipped << std::endl;
+    retVal += ASSERT_BOOL(nSkipped > 0);
+
+    // Each skipped box changes an output by less than the tolerance, and a
+    // point receives the far boxes of its leaf and of each of its ancestors
+    const auto& interactions = exactMult.get_plan()->get_interactions();
+    size_t nFar = 0;
+    for ( uint32_t level = 0; level < maxLevel; ++level ) {
+        size_t levelFar = 0;
+        for ( uint32_t offset = 0; offset < dims.max_ind(level, subDiv, gs::dimensions<nDims>::BOXES_MODE); ++offset ) {
+            levelFar = std::max(levelFar, interactions.far(level, offset).size());
+        }
+        nFar += levelFar;
+    }
+
+    // A skipped interaction changes the outputs, and only by the tolerance
+    bool pruned = false;
+    for ( size_t i = 0; i < size; ++i ) {
+        pruned = pruned || prunedOutput[i] != output[i];
+        retVal += ASSERT_BOOL(std::abs(prunedOutput[i] - output[i]) < std::min(nFar, nSkipped)*tolerance);
+    }
+    retVal += ASSERT_BOOL(pruned);
+
+    const auto expected = dense_multiply(dims, estimator, inputVec);
+    for ( size_t i = 0; i < size; ++i ) {
+        // @todo The method does not currently work for points on the edge of the grid
+        const auto sub = dims.ind2sub(i, maxLevel-1, subDiv);
+        if (
+            ( sub[0] > 0 && sub[0] < gs::pow<2, maxLevel>() - 1 ) &&
+            ( sub[1] > 0 && sub[1] < gs::pow<2, maxLevel>() - 1 )
+        ) {
+            retVal += ASSERT_BOOL(std::abs(expected[i] - output[i]) < 1e-3);
+        }
+    }
+
+    return retVal;
+}
+
+int testq_fmm_exp2_1d_dispatch() {
+    std::cout << "Test fmm exp2 1d dispatch" << std::endl;
+    int retVal = 0;
+
+    const size_t nDims = 1;
+    const uint32_t maxLevel = 7;
+    const double sigma = 2.0;
+    gs::dimensions<nDims> dims(2, maxLevel);
+
+    const size_t size = gs::pow<2, maxLevel>();
+    std::vector<double> inputVec(size);
+    for ( size_t i = 0; i < size; ++i ) {
+        inputVec[i] = 1.0 + 0.25*static_cast<double>((i*7) % 5);
+    }
+
+    // The largest error away from the edges, relative to the largest output
+    const auto relative_error = [&](const std::vector<double>& output, const std::vector<double>& expected) {
+        double maxError = 0.0;
+        double maxValue = 0.0;
+        // @todo The method does not currently work for points on the edge of the grid
+        for ( size_t i = 1; i < size-1; ++i ) {
+            maxError = std::max(maxError, std::abs(expected[i] - output[i]));
+            maxValue = std::max(maxValue, std::abs(expected[i]));
+        }
+        return maxError / maxValue;
+    };
+
+    const auto expected = dense_multiply(dims, gs::exp_squared_est<double, nDims, 1>(sigma), inputVec);
+    size_t previousDegree = 0;
+    for ( const double relError : {1e-2, 1e-4} ) {
+        gs::analytic_multiply_dispatch<double, nDims, gs::exp_squared_est> analyticMult(dims, sigma, relError);
+        // A smaller error needs a larger degree
+        retVal += ASSERT_BOOL(analyticMult.degree() > previousDegree);
+        previousDegree = analyticMult.degree();
+
+        analyticMult.initialise(inputVec);
+        analyticMult.compute();
+        retVal += ASSERT_BOOL(relative_error(analyticMult.output(), expected) < 2*relError);
+    }
+
+    // A wider function, with wider indices and a tolerance
+    const double wideSigma = 12.0;
+    const double relError = 1e-4;
+    const gs::dimensions<nDims, uint64_t> wideDims(2, maxLevel);
+    gs::analytic_multiply_dispatch<
+        double, nDims, gs::exp_squared_est, 1, uint64_t
+    > wideMult(wideDims, wideSigma, relError, 1e-12);
+    wideMult.initialise(std::span<const double>(inputVec));
+    wideMult.compute();
+    std::vector<double> wideOutput(size);
+    wideMult.output(std::span<double>(wideOutput));
+    retVal += ASSERT_BOOL(wideOutput == wideMult.output());
+    const double wideError = relative_error(
+        wideOutput,
+        dense_multiply(wideDims, gs::exp_squared_est<double, nDims, 1>(wideSigma), inputVec)
+    );
+    std::cout << "    degree " << wideMult.degree() << ", relative error: " << wideError << std::endl;
+    retVal += ASSERT_BOOL(wideError < 2*relError);
+
+    return retVal;
+}
+
+/**
+ * \brief A set of scattered points, with a third of them in a small cluster.
+ */
+std::vector<gs::vector<double, 2>> scattered_points(const size_t size, const double width) {
+    std::vector<gs::vector<double, 2>> points;
+    for ( size_t i = 0; i < size; ++i ) {
+        const double x = std::fmod(i*0.7548776662466927, 1.0);
+        const double y = std::fmod(i*0.5698402909980532, 1.0);
+        if ( i % 3 == 0 ) {
+            points.push_back(gs::vector<double, 2>{3.0 + x, 3.0 + y});
+        } else {
+            points.push_back(gs::vector<double, 2>{width*x, width*y});
+        }
+    }
+    return points;
+}
+
+template<size_t D>
+/**
+ * \brief The largest error of a scattered multiplication at degree D,
+ * relative to the largest exact output.
+ */
+double scattered_error(
+    const std::vector<gs::vector<double, 2>>& points,
+    const std::vector<double>& inputVec,
+    const std::vector<double>& expected
+) {
+    gs::scattered_multiply<double, 2, D, gs::exp_squared_est> scatteredMult(
+        points, gs::exp_squared_est<double, 2, D>(2.0), 8
+    );
+    scatteredMult.initialise(inputVec);
+    scatteredMult.compute();
+    const auto output = scatteredMult.output();
+    double maxError = 0.0;
+    double maxValue = 0.0;
+    for ( size_t i = 0; i < output.size(); ++i ) {
+        maxError = std::max(maxError, std::abs(expected[i] - output[i]));
+        maxValue = std::max(maxValue, std::abs(expected[i]));
+    }
+    return maxError / maxValue;
+}
+
+int testq_scattered_exp2_2d() {
+    std::cout << "Test scattered exp2 2d" << std::endl;
+    int retVal = 0;
+
+    // Define base types
+    const size_t nDims = 2;
+    const size_t nDegree = 10;
+
+    // Set the standard deviation.
+    const double sigma = 2.0;
+    gs::exp_squared_est<double, nDims, nDegree> estimator(sigma);
+
+    const size_t size = 600;
+    const auto points = scattered_points(size, 20.0);
+    std::vector<double> inputVec(size);
+    for ( size_t i = 0; i < size; ++i ) {
+        inputVec[i] = static_cast<double>((i*7) % 5) - 2.0;
+    }
+
+    gs::scattered_multiply<
+        double, nDims, nDegree, gs::exp_squared_est
+    > scatteredMult(points, estimator, 8);
+    scatteredMult.initialise(std::span<const double>(inputVec));
+    scatteredMult.compute();
+    const auto output = scatteredMult.output();
+
+    // The output can be written into a buffer in place
+    std::vector<double> spanOutput(size);
+    scatteredMult.output(std::span<double>(spanOutput));
+    retVal += ASSERT_BOOL(spanOutput == output);
+
+    std::vector<double> expected(size, 0.0);
+    double maxError = 0.0;
+    double maxValue = 0.0;
+    for ( size_t i = 0; i < size; ++i ) {
+        for ( size_t j = 0; j < size; ++j ) {
+            expected[i] += estimator(points[i], points[j])*inputVec[j];
+        }
+        maxError = std::max(maxError, std::abs(expected[i] - output[i]));
+        maxValue = std::max(maxValue, std::abs(expected[i]));
+    }
+    std::cout << "    relative error: " << maxError / maxValue << std::endl;
+    retVal += ASSERT_BOOL(maxError < 1.5e-3*maxValue);
+
+    // The error falls as the degree grows, so that it is the truncation of
+    // the series which dominates rather than the translations
+    const std::array<double, 5> errors{
+        scattered_error<2>(points, inputVec, expected),
+        scattered_error<4>(points, inputVec, expected),
+        scattered_error<6>(points, inputVec, expected),
+        scattered_error<8>(points, inputVec, expected),
+        maxError / maxValue
+    };
+    for ( size_t i = 1; i < errors.size(); ++i ) {
+        retVal += ASSERT_BOOL(errors[i] < 0.75*errors[i-1]);
+    }
+    retVal += ASSERT_BOOL(errors.back() < errors.front() / 50);
+
+    // The index type does not change the result
+    gs::scattered_multiply<
+        double, nDims, nDegree, gs::exp_squared_est, 1, uint64_t
+    > wideMult(points, estimator, 8);
+    wideMult.initialise(inputVec);
+    wideMult.compute();
+    const auto wideOutput = wideMult.output();
+    for ( size_t i = 0; i < size; ++i ) {
+        retVal += ASSERT_BOOL(std::abs(wideOutput[i] - output[i]) < 1e-12*maxValue);
+    }
+
+    return retVal;
+}
+
+int test_adaptive_tree_2d() {
+    std::cout << "Test adaptive tree 2d" << std::endl;
+    int retVal = 0;
+
+    const size_t nDims = 2;
+    const uint32_t leafSize = 8;
+    const size_t size = 600;
+    const auto points = scattered_points(size, 20.0);
+    gs::adaptive_tree<nDims, double> tree(points, leafSize);
+
+    retVal += ASSERT_BOOL(tree.size() == size);
+    std::vector<uint32_t> counts(size, 0);
+    for ( uint32_t p = 0; p < size; ++p ) {
+        ++counts[tree.order(p)];
+        for ( size_t d = 0; d < nDims; ++d ) {
+            retVal += ASSERT_BOOL(tree.point(p)(d) == points[tree.order(p)](d));
+        }
+    }
+    for ( const auto count : counts ) {
+        retVal += ASSERT_BOOL(count == 1);
+    }
+
+    for ( uint32_t i = 0; i < tree.n_nodes(); ++i ) {
+        const auto& node = tree[i];
+        if ( !node.is_leaf() ) {
+            retVal += ASSERT_BOOL(tree.near(i).empty());
+            continue;
+        }
+        retVal += ASSERT_BOOL(node.size() <= leafSize);
+
+        // The near and far fields of a leaf and its ancestors cover every point once
+        uint32_t covered = 0;
+        for ( const auto source : tree.near(i) ) {
+            covered += tree[source].size();
+        }
+        uint32_t ancestor = i;
+        while ( true ) {
+            for ( const auto source : tree.far(ancestor) ) {
+                covered += tree[source].size();
+            }
+            if ( ancestor == 0 ) break;
+            ancestor = tree[ancestor].m_parent;
+        }
+        retVal += ASSERT_BOOL(covered == size);
+    }
+
+    return retVal;
+}
+
+int test_interaction_list_2d() {
+    std::cout << "Test interaction list 2d" << std::endl;
+    int retVal = 0;
+
+    const size_t nDims = 2;
+    const uint32_t maxLevel = 4;
+    gs::dimensions<nDims> dims(2, maxLevel);
+    gs::interaction_list<nDims> interactions(dims);
+    const auto subDiv = gs::dimensions<nDims>::BOXES_SUBDIVISION;
+    const uint32_t size = dims.max_ind(maxLevel-1, subDiv, gs::dimensions<nDims>::POINTS_MODE);
+
+    retVal += ASSERT_BOOL(interactions.n_duel_boxes() == 7*7);
+    uint32_t duel = 0;
+    for (
+        auto duelIt = gs::box_duel_iterator<nDims>(dims, maxLevel-1);
+        duelIt < gs::box_duel_iterator<nDims>(dims, maxLevel-1, true);
+        ++duelIt, ++duel
+    ) {
+        retVal += ASSERT_BOOL(interactions.duel_number(*duelIt) == duel);
+        for ( const auto leaf : interactions.leaves(duel) ) {
+            // The near field and the interaction lists of the leaf and
+            // its ancestors cover every point exactly once
+            std::vector<uint32_t> coverage(size, 0);
+            for ( const auto nbr : interactions.neighbours(leaf) ) {
+                for ( const auto point : interactions.leaf_corners(nbr) ) {
+                    ++coverage[point];
+                }
+            }
+            gs::box<nDims> ancestor(dims, maxLevel-1, subDiv, leaf);
+            for ( uint32_t level = maxLevel; level-- > 0; ancestor = ancestor.parent() ) {
+                for ( const auto offset : interactions.far(level, ancestor.get_offset()) ) {
+                    gs::box<nDims> farBox(dims, level, subDiv, offset);
+                    const auto minInd = farBox[0].at_level(maxLevel-1, subDiv);
+                    const auto maxInd = farBox[3].at_level(maxLevel-1, subDiv);
+                    for ( uint32_t i = minInd[0]; i <= maxInd[0]; ++i ) {
+                        for ( uint32_t j = minInd[1]; j <= maxInd[1]; ++j ) {
+                            ++coverage[dims.sub2ind({i, j}, maxLevel-1, subDiv)];
+                        }
+                    }
+                }
+            }
+            for ( const auto count : coverage ) {
+                retVal += ASSERT_BOOL(count == 1);
+            }
+        }
+    }
+    retVal += ASSERT_BOOL(duel == interactions.n_duel_boxes());
+
+    return retVal;
+}
+
+int test_fmm_plan_2d() {
+    std::cout << "Test fmm plan 2d" << std::endl;
+    int retVal = 0;
+
+    const size_t nDims = 2;
+    const uint32_t maxLevel = 3;
+    gs::dimensions<nDims> dims({2, 4}, maxLevel);
+    gs::fmm_plan<nDims, double> plan(dims);
+    const auto subDiv = gs::dimensions<nDims>::BOXES_SUBDIVISION;
+
+    // The implicit positions and centers match those of the lattice
+    retVal += ASSERT_BOOL(plan.size() == dims.max_ind(maxLevel-1, subDiv, gs::dimensions<nDims>::POINTS_MODE));
+    for ( uint32_t i = 0; i < plan.size(); ++i ) {
+        const gs::vector<double, nDims> expected(dims.ind2sub(i, maxLevel-1, subDiv));
+        retVal += ASSERT_BOOL((plan.position(i) - expected).norm() == 0);
+    }
+    for ( uint32_t level = 0; level < maxLevel; ++level ) {
+        const uint32_t nBoxes = dims.max_ind(level, subDiv, gs::dimensions<nDims>::BOXES_MODE);
+        for ( uint32_t offset = 0; offset < nBoxes; ++offset ) {
+            const gs::box<nDims> boxVal(dims, level, subDiv, offset);
+            std::array<gs::vector<double, nDims>, 4> corners;
+            for ( uint32_t k = 0; k < 4; ++k ) {
+                corners[k] = gs::vector<double, nDims>(dims.ind2sub(
+                    dims.sub2ind(boxVal[k].at_level(maxLevel-1, subDiv), maxLevel-1, subDiv),
+                    maxLevel-1,
+                    subDiv
+                ));
+                retVal += ASSERT_BOOL((corners[k] - plan.center(boxVal)).norm() <= plan.radius(level) + 1e-12);
+            }
+            retVal += ASSERT_BOOL((plan.center(level, offset) - gs::mean(corners)).norm() < 1e-12);
+        }
+    }
+
+    // The Morton plan gives the same geometry and lists at the positions in storage
+    const auto mode = gs::dimensions<nDims>::BOXES_MODE;
+    const uint32_t leafLevel = maxLevel-1;
+    const auto& interactions = plan.get_interactions();
+    gs::fmm_plan<nDims, double> mortonPlan(dims, gs::dimensions<nDims>::MORTON);
+    const auto& mortonInteractions = mortonPlan.get_interactions();
+    const uint32_t nLeaves = dims.max_ind(leafLevel, subDiv, mode);
+    const auto to_morton = [&](const uint32_t offset) {
+        return dims.sub2morton(dims.ind2sub(offset, leafLevel, subDiv, mode), leafLevel, mode);
+    };
+    for ( uint32_t offset = 0; offset < nLeaves; ++offset ) {
+        const uint32_t position = to_morton(offset);
+        const auto corners = plan.corner_positions(offset);
+        const auto mortonCorners = mortonPlan.corner_positions(position);
+        retVal += ASSERT_BOOL((mortonPlan.center(leafLevel, position) - plan.center(leafLevel, offset)).norm() == 0);
+        for ( uint32_t k = 0; k < 4; ++k ) {
+            retVal += ASSERT_BOOL((plan.position(interactions.leaf_corners(offset)[k]) - corners[k]).norm() == 0);
+            retVal += ASSERT_BOOL((mortonPlan.position(mortonInteractions.leaf_corners(position)[k]) - corners[k]).norm() == 0);
+            retVal += ASSERT_BOOL((mortonCorners[k] - corners[k]).norm() == 0);
+        }
+        std::vector<uint32_t> neighbours;
+        for ( const auto nbr : interactions.neighbours(offset) ) {
+            neighbours.push_back(to_morton(nbr));
+        }
+        std::vector<uint32_t> mortonNeighbours(
+            mortonInteractions.neighbours(position).begin(),
+            mortonInteractions.neighbours(position).end()
+        );
+        std::sort(neighbours.begin(), neighbours.end());
+        std::sort(mortonNeighbours.begin(), mortonNeighbours.end());
+        retVal += ASSERT_BOOL(neighbours == mortonNeighbours);
+    }
+    return retVal;
+}
+
 #endif  // TESTS_TEST_FMM_HPP_
@@ -3,6 +3,7 @@
 #define TESTS_TEST_GRID_HPP_
 
 #include <set>
+#include <vector>
 
 #include "base/grid.hpp"
 
@@ -67,4 +68,143 @@ int test_grid() {
     return retVal;
 }
 
+int test_grid_visit() {
+    std::cout << "Test grid visit" << std::endl;
+    int retVal = 0;
+    const uint32_t maxLevel = 4;
+    const gs::dimensions<2> dims({4, 2}, maxLevel);
+    const auto subDiv = gs::dimensions<2>::BOXES_SUBDIVISION;
+    const gs::grid<2, double, double> grid(dims, subDiv);
+
+    // Record every call, and the stack of the boxes which have been entered
+    struct recording_visitor {
+        std::vector<gs::compact_box<2>> stack;
+        std::vector<std::set<uint32_t>> visited = std::vector<std::set<uint32_t>>(maxLevel);
+        std::vector<uint32_t> leaves;
+        uint32_t nVisits = 0;
+        bool nested = true;
+
+        void on_enter(const gs::compact_box<2>& boxVal) {
+            nested &= stack.empty() ? boxVal.get_level() == 0 : stack.back() == boxVal.parent();
+            stack.push_back(boxVal);
+            visited[boxVal.get_level()].insert(boxVal.get_offset());
+            ++nVisits;
+        }
+        void on_leaf(const gs::compact_box<2>& boxVal) {
+            nested &= stack.size() == maxLevel-1 && stack.back() == boxVal.parent();
+            visited[boxVal.get_level()].insert(boxVal.get_offset());
+            leaves.push_back(boxVal.get_offset());
+            ++nVisits;
+        }
+        void on_exit(const gs::compact_box<2>& boxVal) {
+            nested &= stack.back() == boxVal;
+            stack.pop_back();
+        }
+    } visitor;
+    grid.visit(visitor);
+
+    // Every box is visited once, and the entries and exits are nested
+    uint32_t nBoxes = 0;
+    for ( uint32_t level = 0; level < maxLevel; ++level ) {
+        const uint32_t nLevel = dims.max_ind(level, subDiv, gs::dimensions<2>::BOXES_MODE);
+        retVal += ASSERT_BOOL(visitor.visited[level].size() == nLevel);
+        nBoxes += nLevel;
+    }
+    retVal += ASSERT_BOOL(visitor.nVisits == nBoxes);
+    retVal += ASSERT_BOOL(visitor.nested);
+    retVal += ASSERT_BOOL(visitor.stack.empty());
+
+    // The leaves are in the order of the box stacks
+    std::vector<uint32_t> stackLeaves;
+    const gs::box_stack_iterator<2> endIt(dims, subDiv, true);
+    for ( gs::box_stack_iterator<2> it(dims, subDiv); it < endIt; ++it ) {
+        stackLeaves.push_back((*it).back().get_offset());
+    }
+    retVal += ASSERT_BOOL(visitor.leaves == stackLeaves);
+    return retVal;
+}
+
+int test_grid_morton() {
+    std::cout << "Test grid morton" << std::endl;
+    int retVal = 0;
+    using grid_type = gs::grid<2, double, double>;
+    const auto subDiv = gs::dimensions<2>::BOXES_SUBDIVISION;
+    gs::dimensions<2> dims({2, 4}, 3);
+    grid_type rowGrid(dims, subDiv);
+    grid_type mortonGrid(dims, subDiv, grid_type::MORTON);
+
+    // Both layouts are addressed in the same way
+    std::vector<double> values(rowGrid.size());
+    for ( uint32_t i = 0; i < values.size(); ++i ) {
+        values[i] = i;
+        mortonGrid[i] = i;
+    }
+    rowGrid.set_grid(values);
+    retVal += ASSERT_BOOL(mortonGrid.row_major() == values);
+    for ( uint32_t i = 0; i < values.size(); ++i ) {
+        retVal += ASSERT_BOOL(rowGrid[i] == mortonGrid[i]);
+    }
+    mortonGrid.set_grid(values);
+    retVal += ASSERT_BOOL(mortonGrid.row_major() == values);
+    for ( uint32_t i = 0; i < values.size(); ++i ) {
+        retVal += ASSERT_BOOL(mortonGrid.point_value(mortonGrid.point_storage_index(i)) == values[i]);
+    }
+
+    // The handles hold the position in storage, and are navigated by the grid
+    for ( uint32_t level = 0; level+1 < dims.max_level(); ++level ) {
+        const uint32_t nBoxes = dims.max_ind(level, subDiv, gs::dimensions<2>::BOXES_MODE);
+        for ( uint32_t i = 0; i < nBoxes; ++i ) {
+            const gs::box<2> boxVal(dims, level, subDiv, i);
+            const gs::box_handle<2> handle(level, mortonGrid.box_storage_index(level, i));
+            retVal += ASSERT_BOOL(mortonGrid.handle(gs::compact_box<2>(dims, level, subDiv, i)) == handle);
+            for ( uint32_t k = 0; k < 4; ++k ) {
+                const uint32_t childOffset = boxVal.subbox(k).get_offset();
+                const gs::box_handle<2> child(level+1, mortonGrid.box_storage_index(level+1, childOffset));
+                retVal += ASSERT_BOOL(mortonGrid.subbox(handle, k) == child);
+                retVal += ASSERT_BOOL(mortonGrid.parent(child) == handle);
+            }
+        }
+    }
+
+    // A compact box reads the box at its position in the storage
+    for ( uint32_t level = 0; level < dims.max_level(); ++level ) {
+        const uint32_t nBoxes = dims.max_ind(level, subDiv, gs::dimensions<2>::BOXES_MODE);
+        for ( uint32_t i = 0; i < nBoxes; ++i ) {
+            mortonGrid[gs::box<2>(dims, level, subDiv, i)] = 1000*level + i;
+        }
+        for ( uint32_t i = 0; i < nBoxes; ++i ) {
+            const gs::compact_box<2> compactBox(dims, level, subDiv, i);
+            retVal += ASSERT_BOOL(mortonGrid[compactBox] == 1000*level + i);
+            retVal += ASSERT_BOOL(&mortonGrid[compactBox] == &mortonGrid[mortonGrid.handle(compactBox)]);
+        }
+    }
+
+    // The corners of each finest box are contiguous in the storage
+    const uint32_t leafLevel = dims.max_level()-1;
+    mortonGrid.iterate([&](gs::box<2>& boxVal, double& boxElement) {
+        boxElement = boxVal.get_offset();
+        std::set<double> stored;
+        for ( const auto& corner : boxVal ) {
+            stored.insert(mortonGrid[corner]);
+        }
+        const uint32_t first = 4*mortonGrid.box_storage_index(leafLevel, boxVal.get_offset());
+        for ( uint32_t k = 0; k < 4; ++k ) {
+            retVal += ASSERT_BOOL(stored.count(*(mortonGrid.begin() + first + k)) == 1);
+        }
+    }, leafLevel);
+    mortonGrid.iterate([&](gs::box<2>& boxVal, double& boxElement) {
+        retVal += ASSERT_BOOL(boxElement == boxVal.get_offset());
+        retVal += ASSERT_BOOL(mortonGrid[boxVal] == boxVal.get_offset());
+    }, leafLevel);
+
+    // The levels are contiguous in a single box storage
+    for ( uint32_t level = 0; level < dims.max_level(); ++level ) {
+        const auto levelStore = mortonGrid.level_storage(level);
+        retVal += ASSERT_BOOL(levelStore.data() == mortonGrid.box_storage().data() + mortonGrid.level_offset(level));
+        retVal += ASSERT_BOOL(levelStore.size() == dims.max_ind(level, subDiv, gs::dimensions<2>::BOXES_MODE));
+    }
+    retVal += ASSERT_BOOL(mortonGrid.box_storage().size() == mortonGrid.level_offset(dims.max_level()));
+    return retVal;
+}
+
 #endif  // TESTS_TEST_GRID_HPP_
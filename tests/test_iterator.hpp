@@ -4,9 +4,12 @@
 
 #include <utility>
 
+#include <set>
+
 #include "base/box_stack_iterator.hpp"
 #include "base/box_duel_iterator.hpp"
 #include "base/box.hpp"
+#include "base/grid.hpp"
 
 int test_bsi_points_1D() {
     std::cout << "Test box stack iterator points 1d" << std::endl;
@@ -83,6 +86,41 @@ int test_bsi_boxes_1D() {
     return retVal;
 }
 
+int test_bsi_root_boxes_2D() {
+    std::cout << "Test box stack iterator root boxes 2d" << std::endl;
+    int retVal = 0;
+
+    // There are more boxes at level 0 than subboxes of a box
+    const gs::dimensions<2> dims(6, 3);
+    const auto subDiv = gs::dimensions<2>::BOXES_SUBDIVISION;
+    const gs::box_stack_iterator<2> endIt(dims, subDiv, true);
+    std::set<uint32_t> leaves;
+    uint32_t nStacks = 0;
+    for ( gs::box_stack_iterator<2> it(dims, subDiv); it < endIt; it++ ) {
+        const auto& boxStack = *it;
+        retVal += ASSERT_BOOL(boxStack.size() == 3);
+        if ( boxStack.size() != 3 ) break;
+        for ( size_t i = 1; i < boxStack.size(); ++i ) {
+            retVal += ASSERT_BOOL(boxStack[i].parent() == boxStack[i-1]);
+        }
+        leaves.insert(boxStack.back().get_offset());
+        ++nStacks;
+    }
+    const uint32_t nLeaves = dims.max_ind(2, subDiv, gs::dimensions<2>::BOXES_MODE);
+    retVal += ASSERT_BOOL(nStacks == nLeaves);
+    retVal += ASSERT_BOOL(leaves.size() == nLeaves);
+
+    // A grid with more levels than the capacity of the stack is rejected
+    bool thrown = false;
+    try {
+        gs::box_stack_iterator<2, uint32_t, 2> shallowIt(dims, subDiv);
+    } catch ( const std::range_error& ) {
+        thrown = true;
+    }
+    retVal += ASSERT_BOOL(thrown);
+    return retVal;
+}
+
 int test_bdi_boxes_1D() {
     std::cout << "Test box duel iterator boxes 1d" << std::endl;
     int retVal = 0;
@@ -178,4 +216,100 @@ int test_bdi_point_boxes() {
     return retVal;
 }
 
+int test_bdi_colours_2D() {
+    std::cout << "Test box duel iterator colours 2d" << std::endl;
+    int retVal = 0;
+
+    const size_t level = 3;
+    gs::dimensions<2> dims(2, level+1);
+    gs::grid<2, double, double> grid(dims, gs::dimensions<2>::BOXES_SUBDIVISION);
+
+    // Every duel box from the iterator
+    std::set<std::pair<uint32_t, uint32_t>> expected;
+    for (
+        auto bdiIt = gs::box_duel_iterator<2>(dims, level);
+        bdiIt < gs::box_duel_iterator<2>(dims, level, true);
+        ++bdiIt
+    ) {
+        expected.insert({(*bdiIt)[0][0], (*bdiIt)[0][1]});
+    }
+
+    std::set<std::pair<uint32_t, uint32_t>> visited;
+    for ( uint32_t colour = 0; colour < 4; ++colour ) {
+        std::set<std::pair<uint32_t, uint32_t>> corners;
+        const uint32_t nBoxes = grid.n_duel_boxes(colour);
+        // Visit the colour in two ranges
+        for ( const auto& range : {std::make_pair(0u, nBoxes/2), std::make_pair(nBoxes/2, nBoxes)} ) {
+            grid.iterate_duel_colour([&](const gs::base_box<2>& duelBox) {
+                retVal += ASSERT_BOOL(visited.insert({duelBox[0][0], duelBox[0][1]}).second);
+                for ( const auto& corner : duelBox ) {
+                    // No corners are shared within a colour
+                    retVal += ASSERT_BOOL(corners.insert({corner[0], corner[1]}).second);
+                }
+            }, colour, range.first, range.second);
+        }
+    }
+    retVal += ASSERT_BOOL(visited == expected);
+
+    return retVal;
+}
+
+int test_bdi_tiles_2D() {
+    std::cout << "Test box duel iterator tiles 2d" << std::endl;
+    int retVal = 0;
+
+    const size_t level = 3;
+    gs::dimensions<2> dims({2, 4}, level+1);
+    using grid_type = gs::grid<2, double, double>;
+    const grid_type rowGrid(dims, gs::dimensions<2>::BOXES_SUBDIVISION);
+    const grid_type mortonGrid(dims, gs::dimensions<2>::BOXES_SUBDIVISION, grid_type::MORTON);
+
+    // Every duel box from the iterator
+    std::set<std::pair<uint32_t, uint32_t>> expected;
+    for (
+        auto bdiIt = gs::box_duel_iterator<2>(dims, level);
+        bdiIt < gs::box_duel_iterator<2>(dims, level, true);
+        ++bdiIt
+    ) {
+        expected.insert({(*bdiIt)[0][0], (*bdiIt)[0][1]});
+    }
+
+    // Both layouts are tiled in the same way
+    for ( const grid_type* gridPtr : {&rowGrid, &mortonGrid} ) {
+        const grid_type& grid = *gridPtr;
+        for ( uint32_t tileLevel = 0; tileLevel <= level; ++tileLevel ) {
+            // Each tile is visited once, and its boxes are contiguous
+            const uint32_t tileWidth = 2u << (level - tileLevel);
+            std::set<std::pair<uint32_t, uint32_t>> visited;
+            std::set<std::pair<uint32_t, uint32_t>> tiles;
+            std::pair<uint32_t, uint32_t> tile{~0u, ~0u};
+            grid.iterate_duel_tiles([&](const gs::base_box<2>& duelBox) {
+                retVal += ASSERT_BOOL(visited.insert({duelBox[0][0], duelBox[0][1]}).second);
+                const std::pair<uint32_t, uint32_t> boxTile{duelBox[0][0] / tileWidth, duelBox[0][1] / tileWidth};
+                if ( boxTile != tile ) {
+                    retVal += ASSERT_BOOL(tiles.insert(boxTile).second);
+                    tile = boxTile;
+                }
+            }, tileLevel);
+            retVal += ASSERT_BOOL(visited == expected);
+
+            // The colours of the tiles partition the duel boxes, and no two boxes
+            // of a colour share a corner
+            std::set<std::pair<uint32_t, uint32_t>> coloured;
+            for ( uint32_t colour = 0; colour < 4; ++colour ) {
+                std::set<std::pair<uint32_t, uint32_t>> corners;
+                grid.iterate_duel_colour_tiles([&](const gs::base_box<2>& duelBox) {
+                    retVal += ASSERT_BOOL(coloured.insert({duelBox[0][0], duelBox[0][1]}).second);
+                    for ( const auto& corner : duelBox ) {
+                        retVal += ASSERT_BOOL(corners.insert({corner[0], corner[1]}).second);
+                    }
+                }, colour, tileLevel, 0, grid.n_duel_tiles(tileLevel));
+            }
+            retVal += ASSERT_BOOL(coloured == expected);
+        }
+    }
+
+    return retVal;
+}
+
 #endif  // TESTS_TEST_ITERATOR_HPP_
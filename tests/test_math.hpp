@@ -120,4 +120,23 @@ int test_polynomial() {
     return retVal;
 }
 
+int test_polynomial_recentre() {
+    std::cout << "Test polynomial recentre" << std::endl;
+    int retVal = 0;
+    std::array<double, 2> tVals{1.5, -0.5};
+    std::array<gs::vector<double, 2>, 2> vVals{
+        gs::vector<double, 2>({1, 2}),
+        gs::vector<double, 2>({-1, 0.5})
+    };
+    const gs::vector<double, 2> shift({0.25, -2});
+    std::array<gs::vector<double, 2>, 2> shiftedVals{vVals[0] - shift, vVals[1] - shift};
+    gs::polynomial<double, 2, 4> poly(vVals, tVals);
+    gs::polynomial<double, 2, 4> shiftedPoly(shiftedVals, tVals);
+    auto recentred = gs::recentre(poly, shift);
+    for ( const auto& x : {gs::vector<double, 2>({1, 0}), gs::vector<double, 2>({0.5, -1.5})} ) {
+        retVal += ASSERT_BOOL(std::abs(recentred.evaluate(x) - shiftedPoly.evaluate(x)) < 1e-8);
+    }
+    return retVal;
+}
+
 #endif  // TESTS_TEST_MATH_HPP_
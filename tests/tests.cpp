@@ -16,6 +16,19 @@ int main(int, char* argv[]) {
     int error = 0;
     error += testq_fmm_exp2_2d();
     error += testq_fmm_exp2_1d();
+    error += testq_fmm_exp2_1d_deep();
+    error += testq_fmm_exp2_2d_threads();
+    error += testq_fmm_exp2_2d_lanes();
+    error += testq_fmm_exp2_2d_reuse();
+    error += testq_fmm_exp2_2d_morton();
+    error += testq_fmm_exp2_2d_mapped();
+    error += testq_fmm_exp2_2d_precision();
+    error += testq_fmm_exp2_2d_sparse();
+    error += testq_fmm_exp2_1d_dispatch();
+    error += testq_scattered_exp2_2d();
+    error += test_interaction_list_2d();
+    error += test_fmm_plan_2d();
+    error += test_adaptive_tree_2d();
     error += test_point_convert_tolocal_sub2ind();
     error += test_point_convert_tolocal_ind2sub();
     error += test_point_convert_topoints_sub2ind();
@@ -25,15 +38,23 @@ int main(int, char* argv[]) {
     error += test_bdi_point_boxes();
     error += test_bdi_boxes_2D();
     error += test_bdi_boxes_1D();
+    error += test_bdi_colours_2D();
+    error += test_bdi_tiles_2D();
     error += test_box_parents_2d();
     error += test_box_parents_3d();
+    error += test_box_handle();
+    error += test_compact_box();
     error += test_exp_estimator();
+    error += test_exp_estimator_translate();
     error += test_bsi_boxes_1D();
     error += test_bsi_points_1D();
+    error += test_bsi_root_boxes_2D();
     error += test_subbox_duel();
     error += test_dimensions_sub2ind();
     error += test_index_call_duel();
     error += test_grid();
+    error += test_grid_morton();
+    error += test_grid_visit();
     error += test_subbox();
     error += test_box_subpoints();
     error += test_box();
@@ -46,9 +67,14 @@ int main(int, char* argv[]) {
     error += test_matrix();
     error += test_tensor();
     error += test_polynomial();
+    error += test_polynomial_recentre();
     error += test_index_call();
     error += test_index_subscript();
     error += test_dimensions_sub2ind_inversion();
+    error += test_dimensions_power_of_two();
+    error += test_dimensions_batched();
+    error += test_dimensions_max_ind_overflow();
+    error += test_dimensions_sub2morton();
     if ( error ) {
         std::cout << error << " tests failed" << std::endl;
     } else {